@@ -0,0 +1,119 @@
+#!/usr/bin/env bash
+# Dataset benchmark suite: runs every mode over every dataset, checks clique
+# counts against manifest.txt, writes median/p95 timings to the results file
+# and flags regressions against a saved baseline.
+#
+# Environment:
+#   DATASETS   dataset names without .txt     (default: every file in dataset/)
+#   MODES      mode names, see mode_args      (default: degeneracy basic t2 t4)
+#   WARMUP     untimed runs per case          (default: 1)
+#   REPS       timed runs per case            (default: 5)
+#   TOLERANCE  allowed median slowdown in %   (default: 10)
+#   MIN_DELTA  slowdown in ms always allowed  (default: 1)
+#   RESULTS    results file                   (default: bench/results.txt)
+#   BASELINE   baseline file                  (default: bench/baseline.txt)
+#   SAVE_BASELINE=1 copies the results to the baseline afterwards
+#
+# Exits with status 1 if any run's clique count is wrong or differs between
+# runs, or any case regressed.
+
+set -u
+cd "$(dirname "$0")/.."
+
+BIN=./main
+MANIFEST=bench/manifest.txt
+WARMUP=${WARMUP:-1}
+REPS=${REPS:-5}
+TOLERANCE=${TOLERANCE:-10}
+MIN_DELTA=${MIN_DELTA:-1}
+RESULTS=${RESULTS:-bench/results.txt}
+BASELINE=${BASELINE:-bench/baseline.txt}
+MODES=${MODES:-degeneracy basic t2 t4}
+if [ -z "${DATASETS:-}" ]; then
+    DATASETS=$(ls dataset/*.txt | xargs -n1 basename | sed 's/\.txt$//')
+fi
+
+mode_args() {
+    case "$1" in
+        degeneracy) echo "" ;;
+        basic) echo "-n" ;;
+        t[0-9]*) echo "-t ${1#t}" ;;
+        *) echo "unknown mode $1" >&2; return 1 ;;
+    esac
+}
+
+# Prints "<clique_count> <elapsed_ms>" for one run
+run_once() {
+    local out
+    out=$($BIN $2 < "dataset/$1.txt") || return 1
+    echo "$out" | awk '/^Clique count:/ {c = $3} /^Elapsed Time:/ {t = $3} END {print c, t}'
+}
+
+# Prints "<median> <p95>" (nearest rank) of the numbers on stdin
+summarize() {
+    sort -g | awk '{v[NR] = $1} END {
+        m = (NR % 2) ? v[(NR + 1) / 2] : (v[NR / 2] + v[NR / 2 + 1]) / 2
+        r = int(0.95 * NR); if (r < 0.95 * NR) r++
+        printf "%.3f %.3f\n", m, v[r]
+    }'
+}
+
+failed=0
+tmp=$(mktemp)
+trap 'rm -f "$tmp"' EXIT
+printf "%-16s %-12s %12s %12s %10s %s\n" dataset mode median_ms p95_ms cliques status > "$tmp"
+
+for ds in $DATASETS; do
+    expected=$(awk -v d="$ds" '$1 == d {print $2}' "$MANIFEST")
+    for mode in $MODES; do
+        args=$(mode_args "$mode") || exit 2
+        for ((i = 0; i < WARMUP; i++)); do run_once "$ds" "$args" > /dev/null; done
+
+        times=""
+        count=""
+        status=ok
+        wrong=""
+        for ((i = 0; i < REPS; i++)); do
+            read -r c t < <(run_once "$ds" "$args")
+            if [ -n "$count" ] && [ "$c" != "$count" ]; then
+                status=UNSTABLE
+                failed=1
+            fi
+            if [ -n "$expected" ] && [ "$c" != "$expected" ]; then wrong=1; fi
+            count=$c
+            times="$times$t"$'\n'
+        done
+        read -r median p95 < <(printf "%s" "$times" | summarize)
+
+        if [ -z "$expected" ]; then
+            status="$status,NO-MANIFEST"
+        elif [ -n "$wrong" ] && [ "$status" = ok ]; then
+            status="WRONG(expected $expected)"
+            failed=1
+        elif [ -n "$wrong" ]; then
+            status="$status,WRONG(expected $expected)"
+            failed=1
+        fi
+
+        if [ -f "$BASELINE" ]; then
+            base=$(awk -v d="$ds" -v m="$mode" '$1 == d && $2 == m {print $3}' "$BASELINE")
+            # Sub-millisecond cases vary by more than the tolerance on noise
+            # alone, so a regression must also exceed MIN_DELTA ms
+            if [ -n "$base" ] && awk -v a="$median" -v b="$base" -v t="$TOLERANCE" -v d="$MIN_DELTA" \
+                'BEGIN {exit !(a > b * (1 + t / 100) && a - b > d)}'; then
+                status="$status,REGRESSION(baseline $base)"
+                failed=1
+            fi
+        fi
+
+        printf "%-16s %-12s %12s %12s %10s %s\n" "$ds" "$mode" "$median" "$p95" "$count" "$status" | tee -a "$tmp"
+    done
+done
+
+cp "$tmp" "$RESULTS"
+echo "Results written to $RESULTS"
+if [ "${SAVE_BASELINE:-0}" = 1 ]; then
+    cp "$RESULTS" "$BASELINE"
+    echo "Baseline saved to $BASELINE"
+fi
+exit $failed
@@ -0,0 +1,277 @@
+// Microbenchmarks of the engine kernels of bron_kerbosch_pivot, run on root
+// subproblems of controlled sizes, both synthetic and extracted from datasets.
+//
+// Usage: bench/microbench [--min-time <ms>] [--seed <n>] [dataset.txt ...]
+//
+// Each kernel runs until --min-time has elapsed (default 200 ms) and reports
+// ns per call and a throughput in the kernel's natural unit: adjacency
+// entries scanned for the engine kernels (counted by the hot-path counters),
+// elements for set intersection, 64-bit words for bitsets, vertices for
+// dgn_order_cal.
+
+#include "../src/graph.h"
+
+using namespace std;
+
+static double min_time_ms = 200;
+static volatile long long sink;
+
+// Calls op(iteration) until min_time_ms has passed; returns ns per call
+template <class Op>
+double time_per_call(Op op) {
+    long long calls = 0;
+    long long batch = 1;
+    auto start = chrono::steady_clock::now();
+    double elapsed_ns = 0;
+    while (elapsed_ns < min_time_ms * 1e6) {
+        for (long long i = 0; i < batch; i++) op(calls + i);
+        calls += batch;
+        if (batch < (1 << 20)) batch *= 2;
+        elapsed_ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+    return elapsed_ns / calls;
+}
+
+// Interleaves batches of base() and of base() followed by extra(), sized to
+// about a millisecond, until min_time_ms has passed. Returns the median ns
+// per call of base() alone and of extra() (the difference of each round), so
+// slow drift of the machine hits both sides of every difference.
+template <class Base, class Extra>
+pair<double, double> time_extra_per_call(Base base, Extra extra) {
+    auto now = []() { return chrono::steady_clock::now(); };
+    auto ns_between = [](chrono::steady_clock::time_point a, chrono::steady_clock::time_point b) {
+        return (double)chrono::duration_cast<chrono::nanoseconds>(b - a).count();
+    };
+    double pair_ns = time_per_call([&](long long) {
+        base();
+        extra();
+    });
+    long long batch = max(1LL, (long long)(1e6 / max(pair_ns, 1.0)));
+    vector<double> base_ns, extra_ns;
+    auto start = now();
+    while (base_ns.size() < 5 || ns_between(start, now()) < min_time_ms * 1e6) {
+        auto t0 = now();
+        for (long long i = 0; i < batch; i++) base();
+        auto t1 = now();
+        for (long long i = 0; i < batch; i++) {
+            base();
+            extra();
+        }
+        auto t2 = now();
+        base_ns.push_back(ns_between(t0, t1) / batch);
+        extra_ns.push_back((ns_between(t1, t2) - ns_between(t0, t1)) / batch);
+    }
+    auto median = [](vector<double>& v) {
+        nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+        return v[v.size() / 2];
+    };
+    return make_pair(median(base_ns), median(extra_ns));
+}
+
+// A time that is not positive could not be measured and prints as n/a
+static void report(const string& kernel, const string& source, int size, double ns, double units_per_call, const char* unit) {
+    cout << left << setw(20) << kernel << setw(22) << source << right << setw(7) << size << setw(14);
+    if (ns <= 0) {
+        cout << "n/a\n";
+        return;
+    }
+    cout << fixed << setprecision(1) << ns;
+    if (units_per_call > 0)
+        cout << setw(12) << setprecision(1) << units_per_call / ns * 1e3 << " M" << unit << "/s";
+    cout << "\n";
+}
+
+static long long scans(const HotPathCounters& c) {
+    return c.pivot_scans + c.x_scans + c.p_scans + c.reorder_steps + c.restore_steps;
+}
+
+// Reference kernels for representations the engine may adopt: merge-based
+// intersection of sorted neighbor lists, and pivot scoring over bit rows.
+static int intersect_sorted(const vector<int>& a, const vector<int>& b) {
+    int count = 0;
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j])
+            i++;
+        else if (a[i] > b[j])
+            j++;
+        else {
+            count++;
+            i++;
+            j++;
+        }
+    }
+    return count;
+}
+
+static int bitset_pivot(const vector<vector<unsigned long long>>& rows, const vector<unsigned long long>& p_mask) {
+    int best = -1, best_count = -1;
+    for (size_t r = 0; r < rows.size(); r++) {
+        int count = 0;
+        for (size_t w = 0; w < p_mask.size(); w++) count += __builtin_popcountll(rows[r][w] & p_mask[w]);
+        if (count > best_count) {
+            best = r;
+            best_count = count;
+        }
+    }
+    return best;
+}
+
+// Run every kernel on the root subproblem of v in g, ranked by rank
+static void bench_subproblem(Graph& g, int v, int i, const vector<int>& rank, const string& source) {
+    int x_size = g.prepare_root(v, i, rank);
+    vector<int> subproblem = g.root_vertices();
+    int size = subproblem.size();
+    int p_idx = x_size, e_idx = size;
+    int p_size = e_idx - p_idx;
+    if (p_size == 0) {
+        g.finish_root();
+        return;
+    }
+
+    g.enable_hot_path_counters();
+    g.select_pivot<true>(0, p_idx, e_idx);
+    double per_call = scans(g.hot_path_counters());
+    double ns = time_per_call([&](long long) { sink = g.select_pivot<false>(0, p_idx, e_idx); });
+    report("pivot scoring", source, size, ns, per_call, "entries");
+
+    // Candidates taken round-robin from P, as the engine does
+    auto cand_at = [&](long long k) { return g.root_vertices()[p_idx + k % p_size]; };
+
+    g.enable_hot_path_counters();
+    for (int k = 0; k < p_size; k++) {
+        int cand = cand_at(k);
+        g.partition_x<true>(cand, 0, p_idx, e_idx);
+        g.partition_p<true>(cand, p_idx, e_idx);
+    }
+    per_call = (double)scans(g.hot_path_counters()) / p_size;
+    ns = time_per_call([&](long long k) {
+        int cand = cand_at(k);
+        sink = g.partition_x<false>(cand, 0, p_idx, e_idx) + g.partition_p<false>(cand, p_idx, e_idx);
+    });
+    report("X/P partition", source, size, ns, per_call, "entries");
+
+    // Reorder alone and reorder + restore for one fixed candidate; both leave
+    // the layout valid for the next call. Restore cannot run on its own, so
+    // it is timed as the extra cost over reorder in the same rounds
+    int cand = cand_at(0);
+    int num_x = g.partition_x<false>(cand, 0, p_idx, e_idx);
+    int num_p = g.partition_p<false>(cand, p_idx, e_idx);
+    g.enable_hot_path_counters();
+    g.reorder_for_child<true>(p_idx, e_idx, num_x, num_p);
+    double reorder_entries = g.hot_path_counters().reorder_steps;
+    g.restore_after_child<true>(cand, p_idx, e_idx, num_x, num_p);
+    double restore_entries = g.hot_path_counters().restore_steps;
+    pair<double, double> reorder_restore_ns =
+        time_extra_per_call([&]() { g.reorder_for_child<false>(p_idx, e_idx, num_x, num_p); },
+                            [&]() { g.restore_after_child<false>(cand, p_idx, e_idx, num_x, num_p); });
+    report("adjacency reorder", source, size, reorder_restore_ns.first, reorder_entries, "entries");
+    report("adjacency restore", source, size, reorder_restore_ns.second, restore_entries, "entries");
+
+    // Sorted-list intersection over consecutive pairs of subproblem vertices
+    vector<vector<int>> sorted_lists;
+    long long total_len = 0;
+    for (int u : subproblem) {
+        Span<const int> neighbors = g.getNeighbors(u);
+        vector<int> list_u(neighbors.begin(), neighbors.end());
+        sort(list_u.begin(), list_u.end());
+        total_len += list_u.size();
+        sorted_lists.push_back(list_u);
+    }
+    ns = time_per_call([&](long long k) {
+        size_t a = k % size, b = (k + 1) % size;
+        sink = intersect_sorted(sorted_lists[a], sorted_lists[b]);
+    });
+    report("set intersection", source, size, ns, 2.0 * total_len / size, "elements");
+
+    // Bit rows over the subproblem: pivot scoring as AND + popcount
+    int words = (size + 63) / 64;
+    vector<vector<unsigned long long>> rows(size, vector<unsigned long long>(words, 0));
+    vector<unsigned long long> p_mask(words, 0);
+    vector<int> local(g.numVertices(), -1);
+    for (int j = 0; j < size; j++) local[subproblem[j]] = j;
+    for (int j = 0; j < size; j++) {
+        for (int w : g.getNeighbors(subproblem[j]))
+            if (local[w] >= 0) rows[j][local[w] / 64] |= 1ULL << (local[w] % 64);
+        if (j >= p_idx) p_mask[j / 64] |= 1ULL << (j % 64);
+    }
+    ns = time_per_call([&](long long) { sink = bitset_pivot(rows, p_mask); });
+    report("bitset pivot", source, size, ns, (double)size * words, "words");
+
+    g.finish_root();
+}
+
+// Graph of k + 1 vertices: a root adjacent to all others, which are joined
+// with probability density. The root sits at rank k / 4, so about a quarter
+// of its neighbors form X.
+static string synthetic_graph(int k, double density, mt19937_64& rng) {
+    vector<pair<int, int>> edges;
+    int root = k / 4;
+    for (int u = 0; u <= k; u++)
+        if (u != root) edges.push_back(make_pair(root, u));
+    bernoulli_distribution coin(density);
+    for (int u = 0; u <= k; u++)
+        for (int w = u + 1; w <= k; w++)
+            if (u != root && w != root && coin(rng)) edges.push_back(make_pair(u, w));
+    ostringstream out;
+    out << k + 1 << ' ' << edges.size() << '\n';
+    for (const auto& e : edges) out << e.first << ' ' << e.second << '\n';
+    return out.str();
+}
+
+static void bench_ordering(Graph& g, const string& source) {
+    double ns = time_per_call([&](long long) { g.dgn_order_cal(); });
+    report("dgn_order_cal", source, g.numVertices(), ns, g.numVertices(), "vertices");
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> datasets;
+    unsigned long long seed = 1;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--min-time" && i + 1 < argc) {
+            min_time_ms = atof(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else {
+            datasets.push_back(arg);
+        }
+    }
+
+    cout << left << setw(20) << "kernel" << setw(22) << "source" << right << setw(7) << "size" << setw(14)
+         << "ns/call" << setw(16) << "throughput" << "\n";
+
+    mt19937_64 rng(seed);
+    const int sizes[] = {16, 64, 256, 1024};
+    for (int k : sizes) {
+        istringstream in(synthetic_graph(k, 0.3, rng));
+        Graph g;
+        g.readGraph(in);
+        vector<int> natural_rank(g.numVertices());
+        for (int u = 0; u < g.numVertices(); u++) natural_rank[u] = u;
+        bench_subproblem(g, k / 4, k / 4, natural_rank, "synthetic p=0.3");
+        if (k == 1024) bench_ordering(g, "synthetic p=0.3");
+    }
+
+    for (const string& path : datasets) {
+        ifstream in(path);
+        Graph g;
+        if (!in.is_open() || !g.readGraph(in)) {
+            cerr << "Error reading graph " << path << "\n";
+            return 1;
+        }
+        string name = path.substr(path.find_last_of('/') + 1);
+        bench_ordering(g, name);
+
+        // Roots whose neighborhood is closest to each target size
+        for (int k : sizes) {
+            int best = -1;
+            for (int u = 0; u < g.numVertices(); u++)
+                if (best < 0 || abs((int)g.getNeighbors(u).size() - k) < abs((int)g.getNeighbors(best).size() - k))
+                    best = u;
+            if (best < 0 || g.getNeighbors(best).empty()) continue;
+            bench_subproblem(g, best, g.rev_dgn[best], g.rev_dgn, name);
+        }
+    }
+    return 0;
+}
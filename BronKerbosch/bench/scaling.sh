@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+# Thread-scaling report for the parallel enumeration.
+#
+# Strong scaling: every dataset and every generated R-MAT graph of a fixed
+# size runs at each thread count; speedup and efficiency are relative to the
+# 1-thread run of the same graph.
+# Weak scaling: the R-MAT scale grows by one per doubling of threads, so the
+# vertices per thread stay fixed; the scaled speedup is t * T(1) / T(t).
+# R-MAT work grows faster than linearly with the scale, so read weak
+# efficiency as a trend.
+#
+# Idle is the mean and maximum share of a worker's time not spent searching
+# (see "Worker load" in the run output). Claims counts root ranges taken from
+# the shared counter, the scheduler's only form of load balancing.
+#
+# Environment:
+#   THREADS      thread counts                 (default: 1 2 4 ... up to nproc)
+#   DATASETS     dataset names without .txt    (default: every file in dataset/)
+#   SCALES       R-MAT scales, strong scaling  (default: 10 11 12; empty disables)
+#   WEAK_SCALE   R-MAT scale at 1 thread       (default: 10; empty disables)
+#   EDGE_FACTOR  R-MAT edge factor             (default: 16)
+#   REPS         timed runs per case, median   (default: 3)
+#   RESULTS      results file                  (default: bench/scaling.txt)
+#
+# Exits with status 1 if the clique count of a graph changes with the thread
+# count or disagrees with manifest.txt.
+
+set -u
+cd "$(dirname "$0")/.."
+
+BIN=./main
+MANIFEST=bench/manifest.txt
+REPS=${REPS:-3}
+RESULTS=${RESULTS:-bench/scaling.txt}
+SCALES=${SCALES-10 11 12}
+WEAK_SCALE=${WEAK_SCALE-10}
+EDGE_FACTOR=${EDGE_FACTOR:-16}
+if [ -z "${THREADS:-}" ]; then
+    max=$(nproc)
+    THREADS=""
+    for ((t = 1; t < max; t *= 2)); do THREADS="$THREADS $t"; done
+    THREADS="$THREADS $max"
+fi
+if [ -z "${DATASETS:-}" ]; then
+    DATASETS=$(ls dataset/*.txt | xargs -n1 basename | sed 's/\.txt$//')
+fi
+
+tmpdir=$(mktemp -d)
+trap 'rm -rf "$tmpdir"' EXIT
+
+# Prints "<clique_count> <elapsed_ms> <mean_idle%> <max_idle%> <claims>" for one run
+run_once() {
+    local out
+    out=$($BIN -i "$1" -t "$2") || return 1
+    echo "$out" | awk '
+        /^Clique count:/ {c = $3}
+        /^Elapsed Time:/ {t = $3}
+        /^Worker load:/ {load = 1; next}
+        load && $1 == "worker" {next}
+        load && $1 ~ /^[0-9]+$/ {n++; idle += $5; if ($5 > max) max = $5; claims += $6; next}
+        {load = 0}
+        END {printf "%s %s %.1f %.1f %d\n", c, t, n ? idle / n : 0, max, claims}'
+}
+
+# Prints the run_once line with the median time out of REPS runs
+run_case() {
+    for ((i = 0; i < REPS; i++)); do run_once "$1" "$2"; done | sort -g -k2 | awk -v r="$REPS" 'NR == int((r + 1) / 2)'
+}
+
+failed=0
+printf "%-18s %-7s %8s %12s %8s %8s %7s %7s %8s %10s %s\n" case kind threads median_ms speedup eff% idle% maxidle claims cliques status \
+    | tee "$tmpdir/report"
+
+# report <case> <kind> <threads> <base_ms> <expected_count> <run_once line>
+report() {
+    local c t idle max claims status=ok
+    read -r c t idle max claims <<< "$6"
+    if [ -n "$5" ] && [ "$c" != "$5" ]; then
+        status="WRONG(expected $5)"
+        failed=1
+    fi
+    awk -v cs="$1" -v k="$2" -v n="$3" -v b="$4" -v t="$t" -v i="$idle" -v m="$max" -v cl="$claims" -v c="$c" -v s="$status" \
+        'BEGIN {sp = t > 0 ? b / t : 0; if (k == "weak") sp *= n; ef = sp * 100 / n
+                printf "%-18s %-7s %8d %12.1f %8.2f %8.1f %7.1f %7.1f %8d %10s %s\n", cs, k, n, t, sp, ef, i, m, cl, c, s}' \
+        | tee -a "$tmpdir/report"
+}
+
+# Strong scaling of one graph file; the expected count comes from the
+# manifest or, failing that, from the 1-thread run
+strong() {
+    local name=$1 file=$2 expected=$3 base="" line
+    for t in $THREADS; do
+        line=$(run_case "$file" "$t") || { echo "$name: run failed" >&2; failed=1; return; }
+        if [ -z "$base" ]; then
+            base=$(echo "$line" | awk '{print $2}')
+            [ -z "$expected" ] && expected=$(echo "$line" | awk '{print $1}')
+        fi
+        report "$name" strong "$t" "$base" "$expected" "$line"
+    done
+}
+
+for ds in $DATASETS; do
+    strong "$ds" "dataset/$ds.txt" "$(awk -v d="$ds" '$1 == d {print $2}' "$MANIFEST")"
+done
+
+for s in $SCALES; do
+    file="$tmpdir/rmat$s.csr"
+    $BIN --generate rmat --scale "$s" --edge-factor "$EDGE_FACTOR" --format csr -o "$file" > /dev/null || exit 2
+    strong "rmat$s" "$file" ""
+done
+
+if [ -n "$WEAK_SCALE" ]; then
+    base=""
+    for t in $THREADS; do
+        s=$WEAK_SCALE
+        for ((k = 1; k < t; k *= 2)); do s=$((s + 1)); done
+        file="$tmpdir/rmat$s.csr"
+        [ -f "$file" ] || $BIN --generate rmat --scale "$s" --edge-factor "$EDGE_FACTOR" --format csr -o "$file" > /dev/null || exit 2
+        line=$(run_case "$file" "$t") || { echo "rmat weak scaling: run failed" >&2; failed=1; break; }
+        [ -z "$base" ] && base=$(echo "$line" | awk '{print $2}')
+        report "rmat$s" weak "$t" "$base" "" "$line"
+    done
+fi
+
+cp "$tmpdir/report" "$RESULTS"
+echo "Scaling report written to $RESULTS"
+exit $failed
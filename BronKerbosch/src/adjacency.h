@@ -0,0 +1,58 @@
+#ifndef ADJACENCY_H
+#define ADJACENCY_H
+
+#include <bits/stdc++.h>
+
+#include "huge_pages.h"
+
+using namespace std;
+
+// Neighbor list of one vertex: a view into the flat adjacency array. The
+// engine reorders lists in place through it, but never resizes them.
+template <class T>
+class Span {
+private:
+    T* first;
+    T* last;
+
+public:
+    Span(T* first, T* last) : first(first), last(last) {}
+
+    T* begin() const { return first; }
+    T* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    T& operator[](size_t i) const { return first[i]; }
+};
+
+// All neighbor lists in two arrays (CSR): the neighbors of u are
+// targets[offsets[u], offsets[u + 1]). Both are on huge pages where
+// available (see huge_pages.h), and copying the graph for a parallel worker
+// copies two arrays instead of n lists.
+struct Adjacency {
+    HugeVector<long long> offsets;  // n + 1 entries
+    HugeVector<int> targets;  // both directions of every edge
+
+    int size() const { return offsets.empty() ? 0 : (int)offsets.size() - 1; }
+
+    Span<int> operator[](int u) { return Span<int>(targets.data() + offsets[u], targets.data() + offsets[u + 1]); }
+
+    Span<const int> operator[](int u) const {
+        return Span<const int>(targets.data() + offsets[u], targets.data() + offsets[u + 1]);
+    }
+
+    // Flatten per-vertex lists, releasing each as it is copied
+    void assign(vector<vector<int>>& lists) {
+        offsets.assign(lists.size() + 1, 0);
+        for (size_t u = 0; u < lists.size(); u++) offsets[u + 1] = offsets[u] + lists[u].size();
+        targets.resize(offsets.back());
+        for (size_t u = 0; u < lists.size(); u++) {
+            copy(lists[u].begin(), lists[u].end(), targets.begin() + offsets[u]);
+            vector<int>().swap(lists[u]);
+        }
+    }
+
+    long long bytes() const { return sizeof(long long) * offsets.capacity() + sizeof(int) * targets.capacity(); }
+};
+
+#endif
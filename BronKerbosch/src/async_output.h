@@ -0,0 +1,330 @@
+#ifndef ASYNC_OUTPUT_H
+#define ASYNC_OUTPUT_H
+
+#include <bits/stdc++.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "memory.h"
+
+using namespace std;
+
+// Totals of one AsyncOutput, complete once it is closed
+struct OutputStats {
+    long long bytes = 0;
+    long long buffers = 0;  // handed to the writer thread
+    long long write_ns = 0;  // writer thread time in write()
+    long long stall_ns = 0;  // producer time waiting for a free buffer
+    long long stalls = 0;
+    bool failed = false;
+
+    string summary() const {
+        ostringstream out;
+        out << fixed << setprecision(1) << MemoryLedger::format_bytes(bytes) << " in " << buffers << " buffers";
+        if (write_ns > 0) out << ", written at " << bytes / 1e6 / (write_ns / 1e9) << " MB/s";
+        out << ", producer waited " << stall_ns / 1e6 << " ms for " << stalls << " free buffers";
+        return out.str();
+    }
+};
+
+// Bounded lock-free queue of buffer indices between exactly one pushing and
+// one popping thread: the OutputWriter handing a file's written buffers
+// back, and the file's producer taking them.
+class SpscRing {
+private:
+    static const unsigned kSlots = 8;  // a power of two, more than the buffers in flight
+    atomic<unsigned> head{0};  // next to pop
+    atomic<unsigned> tail{0};  // next to push
+    int slots[kSlots];
+
+public:
+    bool push(int value) {
+        unsigned t = tail.load(memory_order_relaxed);
+        if (t - head.load() == kSlots) return false;
+        slots[t % kSlots] = value;
+        tail.store(t + 1);
+        return true;
+    }
+
+    bool pop(int& value) {
+        unsigned h = head.load(memory_order_relaxed);
+        if (h == tail.load()) return false;
+        value = slots[h % kSlots];
+        head.store(h + 1);
+        return true;
+    }
+
+    bool empty() const { return head.load() == tail.load(); }
+};
+
+class AsyncOutputBuffer;
+
+// Bounded lock-free queue from any number of pushing threads to one popping
+// thread (Vyukov's bounded queue): each cell's sequence number says whether
+// it is free for the push of that position or holds the value for its pop.
+// Sequence numbers are stored and loaded sequentially consistent, so that
+// the popping thread about to sleep either sees a push or is seen waiting
+// by the pusher (see OutputWriter::run).
+template <class T>
+class MpscQueue {
+private:
+    static const size_t kCells = 1024;  // a power of two
+    struct Cell {
+        atomic<size_t> seq;
+        T value;
+    };
+    Cell cells[kCells];
+    atomic<size_t> tail{0};  // next to push
+    size_t head = 0;  // next to pop, popping thread only
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < kCells; i++) cells[i].seq.store(i, memory_order_relaxed);
+    }
+
+    bool push(const T& value) {
+        size_t pos = tail.load(memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos % kCells];
+            long long diff = (long long)cell.seq.load() - (long long)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = tail.load(memory_order_relaxed);
+            }
+        }
+        Cell& cell = cells[pos % kCells];
+        cell.value = value;
+        cell.seq.store(pos + 1);
+        return true;
+    }
+
+    bool pop(T& value) {
+        Cell& cell = cells[head % kCells];
+        if (cell.seq.load() != head + 1) return false;
+        value = cell.value;
+        cell.seq.store(head + kCells);
+        head++;
+        return true;
+    }
+
+    bool empty() const { return cells[head % kCells].seq.load() != head + 1; }
+};
+
+// The I/O thread shared by every AsyncOutput: files push their filled
+// buffers onto one MpscQueue, and the thread writes them in arrival order
+// and hands each back to its file. Created on first use and never
+// destroyed, so that outputs still open while the program exits (or static
+// objects closing theirs) never find it gone.
+class OutputWriter {
+public:
+    struct Job {
+        AsyncOutputBuffer* file;
+        int buffer;
+    };
+
+private:
+    MpscQueue<Job> queue;
+    mutex m;  // sleeping only: the queue is the handoff
+    condition_variable cv;
+    atomic<bool> waiting{false};
+
+    // Started once every member above exists
+    OutputWriter() { thread([this]() { run(); }).detach(); }
+
+    inline void run();
+
+public:
+    static OutputWriter& instance() {
+        static OutputWriter* writer = new OutputWriter();
+        return *writer;
+    }
+
+    void submit(const Job& job) {
+        while (!queue.push(job)) this_thread::yield();
+        if (!waiting.load()) return;
+        lock_guard<mutex> lock(m);
+        cv.notify_one();
+    }
+};
+
+// Stream buffer that hands filled buffers to the shared OutputWriter
+// instead of writing them itself: kBuffers buffers of kBufferBytes cycle
+// between the producer and the writer, full ones through the writer's
+// queue and written ones back through this file's SpscRing. The producer
+// only blocks when all its buffers are queued or being written
+// (backpressure from a slow disk, or from the other files ahead of it);
+// that time is counted as a stall. flush() does not hand over a partial
+// buffer, close() does.
+class AsyncOutputBuffer : public streambuf {
+public:
+    static const int kBuffers = 4;
+    static const size_t kBufferBytes = 1 << 20;
+
+private:
+    friend class OutputWriter;
+
+    int fd = -1;
+    vector<vector<char>> buffers;
+    size_t lengths[kBuffers];
+    int current = -1;  // buffer being filled by the producer
+    SpscRing free_buffers;
+
+    // The writer recycles a buffer under m, so that once close() has taken
+    // m after the last one, the writer no longer touches this file
+    mutex m;
+    condition_variable cv;
+
+    OutputStats totals;
+
+    // Writer thread; after a failed write the remaining buffers are
+    // dropped, but still recycled so that the producer never waits for them
+    void write_buffer(int b) {
+        auto start = chrono::steady_clock::now();
+        const char* data = buffers[b].data();
+        size_t left = lengths[b];
+        while (left > 0 && !totals.failed) {
+            ssize_t written = ::write(fd, data, left);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) {
+                totals.failed = true;
+                break;
+            }
+            data += written;
+            left -= written;
+        }
+        totals.write_ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+
+    // Writer thread
+    void recycle(int b) {
+        lock_guard<mutex> lock(m);
+        free_buffers.push(b);
+        cv.notify_all();
+    }
+
+    void take_buffer() {
+        if (!free_buffers.pop(current)) {
+            auto start = chrono::steady_clock::now();
+            unique_lock<mutex> lock(m);
+            cv.wait(lock, [&]() { return free_buffers.pop(current); });
+            totals.stall_ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+            totals.stalls++;
+        }
+        setp(buffers[current].data(), buffers[current].data() + kBufferBytes);
+    }
+
+    void hand_over() {
+        lengths[current] = pptr() - pbase();
+        totals.bytes += lengths[current];
+        totals.buffers++;
+        OutputWriter::instance().submit(OutputWriter::Job{this, current});
+        current = -1;
+        setp(nullptr, nullptr);
+    }
+
+protected:
+    int_type overflow(int_type c) override {
+        if (current < 0) return traits_type::eof();
+        hand_over();
+        take_buffer();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override { return 0; }
+
+public:
+    ~AsyncOutputBuffer() { close(); }
+
+    bool open(const string& filename) {
+        fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        buffers.assign(kBuffers, vector<char>(kBufferBytes));
+        for (int b = 0; b < kBuffers; b++) free_buffers.push(b);
+        take_buffer();
+        return true;
+    }
+
+    bool is_open() const { return fd >= 0; }
+
+    // Hand over the last buffer, wait for the writer to return every buffer
+    // and close the file; false if any write failed
+    bool close() {
+        if (fd < 0) return !totals.failed;
+        if (pptr() > pbase()) hand_over();
+        {
+            unique_lock<mutex> lock(m);
+            int held = current >= 0 ? 1 : 0;
+            int b;
+            cv.wait(lock, [&]() {
+                while (free_buffers.pop(b)) held++;
+                return held == kBuffers;
+            });
+        }
+        if (::close(fd) != 0) totals.failed = true;
+        fd = -1;
+        current = -1;
+        setp(nullptr, nullptr);
+        vector<vector<char>>().swap(buffers);
+        return !totals.failed;
+    }
+
+    long long bytes() const { return fd >= 0 ? (long long)kBuffers * kBufferBytes : 0; }
+    const OutputStats& stats() const { return totals; }
+};
+
+void OutputWriter::run() {
+    for (;;) {
+        Job job;
+        if (queue.pop(job)) {
+            job.file->write_buffer(job.buffer);
+            job.file->recycle(job.buffer);
+            continue;
+        }
+        unique_lock<mutex> lock(m);
+        waiting.store(true);
+        cv.wait(lock, [&]() { return !queue.empty(); });
+        waiting.store(false);
+    }
+}
+
+// An output file stream written by the shared I/O thread (see
+// AsyncOutputBuffer), for the exporters: formatting stays on the calling
+// thread, the writes move off it.
+class AsyncOutput : public ostream {
+private:
+    AsyncOutputBuffer buffer;
+
+public:
+    AsyncOutput() : ostream(nullptr) { rdbuf(&buffer); }
+
+    explicit AsyncOutput(const string& filename) : AsyncOutput() { open(filename); }
+
+    bool open(const string& filename) {
+        bool ok = buffer.open(filename);
+        if (!ok) setstate(ios::failbit);
+        return ok;
+    }
+
+    bool is_open() const { return buffer.is_open(); }
+
+    bool close() {
+        bool ok = buffer.close();
+        if (!ok) setstate(ios::badbit);
+        return ok;
+    }
+
+    // Memory held by the buffers while open
+    long long bytes() const { return buffer.bytes(); }
+    static long long buffer_bytes() { return (long long)AsyncOutputBuffer::kBuffers * AsyncOutputBuffer::kBufferBytes; }
+    const OutputStats& stats() const { return buffer.stats(); }
+};
+
+#endif
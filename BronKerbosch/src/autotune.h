@@ -0,0 +1,150 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <bits/stdc++.h>
+
+#include "config.h"
+#include "graph.h"
+
+using namespace std;
+
+// Benchmarks engine configurations on a random sample of roots and returns
+// the fastest. Each configuration runs the sample (in root order) a few
+// times and keeps the best time, projected to the whole graph by
+// n / |sample| plus the cost of computing the ordering and hub rows. The
+// hub count is tuned next, at the best ordering and pivot policy, and the
+// grain last, only with several threads; on the sample the grain is scaled
+// down by the same factor so each claim covers the same share of the work
+// as in a full run. Hub counts that give the same rows and grains that
+// scale to the same sample grain are measured once, and a later candidate
+// only replaces the best one when it wins by more than their spread over
+// the repetitions.
+inline EngineConfig autotune_engine(Graph& g, const EngineConfig& base, int num_threads, ostream& out,
+                                    unsigned long long seed = 1) {
+    const int reps = 3;
+    int n = g.numVertices();
+    EngineConfig best = base;
+    if (n == 0) return best;
+
+    int sample_size = min(n, max(256, n / 50));
+    vector<int> sample(n);
+    for (int v = 0; v < n; v++) sample[v] = v;
+    mt19937_64 rng(seed);
+    shuffle(sample.begin(), sample.end(), rng);
+    sample.resize(sample_size);
+
+    auto ms_since = [](chrono::steady_clock::time_point from) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - from).count();
+    };
+
+    auto order_start = chrono::steady_clock::now();
+    g.dgn_order_cal();
+    double degeneracy_ms = ms_since(order_start);
+    vector<int> natural_order(n);
+    for (int v = 0; v < n; v++) natural_order[v] = v;
+
+    // Positions of the sampled roots in the given order, ascending
+    auto sample_ranks = [&](const vector<int>& rank) {
+        vector<int> ranks;
+        for (int v : sample) ranks.push_back(rank[v]);
+        sort(ranks.begin(), ranks.end());
+        return ranks;
+    };
+
+    auto sample_grain = [&](int grain) { return max(1, (int)((long long)grain * sample_size / n)); };
+
+    // Best and worst sample time over the repetitions
+    auto run_sample = [&](const EngineConfig& c, int threads) {
+        const vector<int>& order = c.degeneracy ? g.dgn_order : natural_order;
+        const vector<int>& rank = c.degeneracy ? g.rev_dgn : natural_order;
+        vector<int> ranks = sample_ranks(rank);
+        g.set_pivot_from_p(c.pivot_from_p);
+        g.set_root_grain(sample_grain(c.grain));
+        pair<double, double> ms(1e300, 0);
+        for (int r = 0; r < reps; r++) {
+            auto start = chrono::steady_clock::now();
+            g.run_root_ranks(order, rank, ranks, threads);
+            double elapsed = ms_since(start);
+            ms.first = min(ms.first, elapsed);
+            ms.second = max(ms.second, elapsed);
+        }
+        return ms;
+    };
+
+    // Hub rows of the given count, returning the time to build them
+    auto build_hubs = [&](int hubs) {
+        auto start = chrono::steady_clock::now();
+        g.build_hub_rows(hubs);
+        return ms_since(start);
+    };
+    double base_hubs_ms = build_hubs(base.hubs);
+
+    out << "Autotuning on " << sample_size << " of " << n << " roots, " << num_threads << " thread"
+        << (num_threads > 1 ? "s" : "") << ", best of " << reps << ":\n";
+    out << "  " << left << setw(52) << "configuration" << right << setw(12) << "sample_ms" << setw(14)
+        << "projected_ms" << "\n";
+    auto report = [&](const EngineConfig& c, double sample_ms, double projected_ms) {
+        out << "  " << left << setw(52) << c.describe() << right << fixed << setprecision(2) << setw(12) << sample_ms
+            << setw(14) << projected_ms << defaultfloat << "\n";
+    };
+
+    double best_ms = 1e300, best_spread_ms = 0, best_hubs_ms = base_hubs_ms;
+    // Projects c's sample times on the current hub rows, built in hubs_ms,
+    // reports them and keeps c if it is faster; with a margin, only if it
+    // wins by more than both spreads
+    auto consider = [&](const EngineConfig& c, double hubs_ms, bool margin) {
+        pair<double, double> ms = run_sample(c, num_threads);
+        double scale = (double)n / sample_size;
+        double projected_ms = ms.first * scale + (c.degeneracy ? degeneracy_ms : 0) + hubs_ms;
+        double spread_ms = (ms.second - ms.first) * scale;
+        report(c, ms.first, projected_ms);
+        if (projected_ms + (margin ? max(spread_ms, best_spread_ms) : 0) < best_ms) {
+            best_ms = projected_ms;
+            best_spread_ms = spread_ms;
+            best_hubs_ms = hubs_ms;
+            best = c;
+        }
+    };
+
+    for (int degeneracy = 1; degeneracy >= 0; degeneracy--) {
+        for (int from_p = 0; from_p <= 1; from_p++) {
+            EngineConfig c = base;
+            c.degeneracy = degeneracy;
+            c.pivot_from_p = from_p;
+            consider(c, base_hubs_ms, false);
+        }
+    }
+
+    // Counts whose threshold degree leaves the same hubs build the same rows
+    const int hub_counts[] = {0, 256, 1024, 4096, 16384};
+    set<int> measured_hubs = {g.hubs() ? g.hubs()->num_hubs() : 0};
+    EngineConfig tuned = best;
+    for (int hubs : hub_counts) {
+        if (hubs == tuned.hubs) continue;
+        EngineConfig c = tuned;
+        c.hubs = hubs;
+        double build_ms = build_hubs(hubs);
+        if (measured_hubs.insert(g.hubs() ? g.hubs()->num_hubs() : 0).second) consider(c, build_ms, true);
+    }
+    build_hubs(best.hubs);
+
+    if (num_threads > 1) {
+        const int grains[] = {1, 16, 64, 256, 1024};
+        tuned = best;
+        set<int> measured_grains = {sample_grain(tuned.grain)};
+        for (int grain : grains) {
+            if (!measured_grains.insert(sample_grain(grain)).second) continue;
+            EngineConfig c = tuned;
+            c.grain = grain;
+            consider(c, best_hubs_ms, true);
+        }
+    }
+
+    g.set_pivot_from_p(best.pivot_from_p);
+    g.set_root_grain(best.grain);
+    out << "Best configuration: " << best.describe() << " (projected " << fixed << setprecision(1) << best_ms
+        << defaultfloat << " ms)\n";
+    return best;
+}
+
+#endif
@@ -0,0 +1,263 @@
+#ifndef CLIQUE_GRAPH_H
+#define CLIQUE_GRAPH_H
+
+#include <bits/stdc++.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "async_output.h"
+#include "clique_store.h"
+#include "csr_io.h"
+
+using namespace std;
+
+struct CliqueGraphStats {
+    int t = 0;
+    long long nodes = 0;  // maximal cliques
+    long long edges = 0;
+    long long isolated = 0;  // cliques without neighbors
+    long long max_degree = 0;
+    long long prefix_entries = 0;  // (vertex, clique) entries of the prefix index
+    long long candidates = 0;  // clique pairs met in the prefix index, all intersected
+    long long windows = 0;
+    long long window_bytes = 0;  // largest window of buffered neighbor lists
+    long long scratch_bytes = 0;
+    long long ns = 0;
+    int threads = 1;
+    OutputStats io;
+};
+
+// The clique overlap graph of a clique store: one node per maximal clique
+// (its clique id), an edge between two cliques sharing at least t vertices.
+//
+// Candidates come from prefix filtering, as in set similarity joins: the
+// vertices are ranked by the length of their postings, and the prefix of a
+// clique c is its |c| - t + 1 lowest ranked vertices. Two cliques sharing t
+// vertices share one in their prefixes: the lowest ranked shared vertex has
+// t - 1 vertices of either clique ranked above it. So only the prefix vertices
+// are indexed (hubs, in many cliques, are rarely in a prefix), c meets the
+// cliques indexed under its own prefix vertices, and each is intersected
+// with c. Every clique finds its own neighbor list this way, so the cliques
+// are independent and the lists come out whole, in clique order, for the
+// CSR file.
+//
+// The lists are not all kept: cliques are taken in windows, and the prefix
+// postings c meets bound its degree, so a window holds cliques whose bounds
+// sum to at most kWindowEntries (or a single clique above it). Threads fill
+// a window's lists in place, then they are written out through an
+// AsyncOutput while the degrees are kept as the offsets. The header and
+// offsets are written over a zeroed placeholder at the end.
+class CliqueOverlapGraph {
+private:
+    static const int kCliqueChunk = 64;
+    static const long long kWindowEntries = 16 << 20;
+
+    struct Scratch {
+        vector<unsigned> seen;  // c + 1 once d was met from c
+        vector<unsigned> in_clique;  // c + 1 for the vertices of c
+        vector<pair<size_t, unsigned>> by_postings;
+        CliqueGraphStats stats;
+    };
+
+    const CliqueIndex& index;
+    int t;
+
+    // Prefix index: the cliques with v in their prefix
+    vector<unsigned long long> prefix_first;
+    vector<unsigned> prefix_cliques;
+
+    Span<const unsigned> prefix_postings(unsigned v) const {
+        return Span<const unsigned>(prefix_cliques.data() + prefix_first[v], prefix_cliques.data() + prefix_first[v + 1]);
+    }
+
+    // The prefix of c, the first |c| - t + 1 entries of by_postings; false
+    // for cliques of fewer than t vertices
+    bool pick_prefix(long long c, vector<pair<size_t, unsigned>>& by_postings) const {
+        Span<const unsigned> members = index.clique(c);
+        if ((long long)members.size() < t) return false;
+        by_postings.clear();
+        for (unsigned v : members) by_postings.push_back(make_pair(index.cliques_of(v).size(), v));
+        size_t prefix = members.size() - t + 1;
+        partial_sort(by_postings.begin(), by_postings.begin() + prefix, by_postings.end());
+        by_postings.resize(prefix);
+        return true;
+    }
+
+    // At least t vertices of d in c, whose vertices are marked c + 1 in s.in_clique
+    bool overlaps(unsigned c, Span<const unsigned> d, const Scratch& s) const {
+        long long need = t;
+        for (const unsigned* w = d.begin(); w != d.end(); w++) {
+            if (need > d.end() - w) return false;
+            if (s.in_clique[*w] == c + 1 && --need == 0) return true;
+        }
+        return false;
+    }
+
+    // The neighbors of c, ascending, written to out; returns their number
+    long long neighbors(unsigned c, unsigned* out, Scratch& s) const {
+        if (!pick_prefix(c, s.by_postings)) return 0;
+        for (unsigned v : index.clique(c)) s.in_clique[v] = c + 1;
+        long long degree = 0;
+        for (const auto& p : s.by_postings) {
+            for (unsigned d : prefix_postings(p.second)) {
+                if (d == c || s.seen[d] == c + 1) continue;
+                s.seen[d] = c + 1;
+                s.stats.candidates++;
+                if (overlaps(c, index.clique(d), s)) out[degree++] = d;
+            }
+        }
+        sort(out, out + degree);
+        return degree;
+    }
+
+    // The prefix index, and the degree bound of each clique in bounds[c + 1]
+    void build_prefix_index(int threads, vector<Scratch>& scratch, vector<unsigned long long>& bounds) {
+        long long num_cliques = index.num_cliques();
+        long long n = index.num_vertices();
+        vector<atomic<unsigned long long>> fill(n);
+        for (long long v = 0; v < n; v++) fill[v].store(0, memory_order_relaxed);
+        atomic<long long> next(0);
+        parallel_for(threads, [&](int th) {
+            for (long long first; (first = next.fetch_add(kCliqueChunk * 16)) < num_cliques;)
+                for (long long c = first; c < min(first + kCliqueChunk * 16, num_cliques); c++)
+                    if (pick_prefix(c, scratch[th].by_postings))
+                        for (const auto& p : scratch[th].by_postings) fill[p.second].fetch_add(1, memory_order_relaxed);
+        });
+        prefix_first.assign(n + 1, 0);
+        for (long long v = 0; v < n; v++) {
+            prefix_first[v + 1] = prefix_first[v] + fill[v].load(memory_order_relaxed);
+            fill[v].store(prefix_first[v], memory_order_relaxed);
+        }
+        prefix_cliques.resize(prefix_first[n]);
+        next = 0;
+        parallel_for(threads, [&](int th) {
+            for (long long first; (first = next.fetch_add(kCliqueChunk * 16)) < num_cliques;)
+                for (long long c = first; c < min(first + kCliqueChunk * 16, num_cliques); c++) {
+                    bounds[c + 1] = 0;
+                    if (!pick_prefix(c, scratch[th].by_postings)) continue;
+                    for (const auto& p : scratch[th].by_postings) {
+                        prefix_cliques[fill[p.second].fetch_add(1, memory_order_relaxed)] = c;
+                        bounds[c + 1] += prefix_first[p.second + 1] - prefix_first[p.second];
+                    }
+                }
+        });
+    }
+
+    static bool write_zeros(AsyncOutput& out, unsigned long long bytes) {
+        static const char zeros[4096] = {};
+        for (; bytes > 0 && out; bytes -= min<unsigned long long>(bytes, sizeof(zeros)))
+            out.write(zeros, min<unsigned long long>(bytes, sizeof(zeros)));
+        return (bool)out;
+    }
+
+    static bool write_at(int fd, const void* data, size_t bytes, off_t pos) {
+        const char* p = (const char*)data;
+        while (bytes > 0) {
+            ssize_t written = ::pwrite(fd, p, bytes, pos);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return false;
+            p += written;
+            pos += written;
+            bytes -= written;
+        }
+        return true;
+    }
+
+public:
+    CliqueOverlapGraph(const CliqueIndex& index, int t) : index(index), t(t) {}
+
+    // Build the graph into a CSR file (see csr_io.h)
+    bool write(const string& filename, int threads, CliqueGraphStats& s) {
+        auto start = chrono::steady_clock::now();
+        s = CliqueGraphStats();
+        s.t = t;
+        s.threads = max(1, threads);
+        long long num_cliques = index.num_cliques();
+        s.nodes = num_cliques;
+
+        AsyncOutput out(filename);
+        if (!out.is_open()) {
+            cerr << "Error: Could not open file " << filename << " for writing." << endl;
+            return false;
+        }
+        write_zeros(out, csr_neighbors_pos(num_cliques));
+
+        vector<Scratch> scratch(s.threads);
+        for (Scratch& local : scratch) {
+            local.seen.assign(num_cliques, 0);
+            local.in_clique.assign(index.num_vertices(), 0);
+        }
+
+        // offsets[c + 1] holds the degree bound of c, then its degree, then
+        // the prefix sums
+        vector<unsigned long long> offsets(num_cliques + 1, 0);
+        build_prefix_index(s.threads, scratch, offsets);
+        s.prefix_entries = prefix_cliques.size();
+        atomic<long long> next(0);
+
+        vector<unsigned> window;
+        vector<unsigned long long> slot;  // of each window clique in window
+        for (long long first = 0; first < num_cliques;) {
+            // Cliques up to the entry budget, at least one
+            long long last = first;
+            long long entries = 0;
+            slot.clear();
+            while (last < num_cliques && (last == first || entries + (long long)offsets[last + 1] <= kWindowEntries)) {
+                slot.push_back(entries);
+                entries += offsets[last + 1];
+                last++;
+            }
+            if ((long long)window.size() < entries) vector<unsigned>(entries).swap(window);
+            s.windows++;
+
+            next = first;
+            parallel_for(s.threads, [&](int th) {
+                for (long long chunk; (chunk = next.fetch_add(kCliqueChunk)) < last;)
+                    for (long long c = chunk; c < min(chunk + kCliqueChunk, last); c++)
+                        offsets[c + 1] = neighbors(c, window.data() + slot[c - first], scratch[th]);
+            });
+
+            for (long long c = first; c < last; c++)
+                out.write((const char*)(window.data() + slot[c - first]), offsets[c + 1] * sizeof(unsigned));
+            first = last;
+        }
+        s.window_bytes = sizeof(unsigned) * window.capacity();
+
+        for (long long c = 0; c < num_cliques; c++) {
+            s.max_degree = max<long long>(s.max_degree, offsets[c + 1]);
+            if (offsets[c + 1] == 0) s.isolated++;
+            offsets[c + 1] += offsets[c];
+        }
+        s.edges = offsets[num_cliques] / 2;
+
+        if (!out.close()) {
+            cerr << "Error: Could not write " << filename << endl;
+            return false;
+        }
+        s.io = out.stats();
+
+        // Header and offsets over the placeholder
+        int fd = ::open(filename.c_str(), O_WRONLY);
+        CSRHeader header = {(unsigned long long)num_cliques, (unsigned long long)s.edges};
+        bool ok = fd >= 0 && write_at(fd, CSR_MAGIC, sizeof(CSR_MAGIC), 0) &&
+                  write_at(fd, &header, sizeof(header), sizeof(CSR_MAGIC)) &&
+                  write_at(fd, offsets.data(), offsets.size() * sizeof(offsets[0]), csr_offsets_pos());
+        if (fd >= 0 && ::close(fd) != 0) ok = false;
+        if (!ok) {
+            cerr << "Error: Could not write " << filename << endl;
+            return false;
+        }
+
+        s.scratch_bytes = s.window_bytes + sizeof(offsets[0]) * (offsets.capacity() + prefix_first.capacity()) +
+                          sizeof(prefix_cliques[0]) * prefix_cliques.capacity() + sizeof(slot[0]) * slot.capacity();
+        for (const Scratch& local : scratch) {
+            s.candidates += local.stats.candidates;
+            s.scratch_bytes += sizeof(unsigned) * (local.seen.capacity() + local.in_clique.capacity());
+        }
+        s.ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        return true;
+    }
+};
+
+#endif
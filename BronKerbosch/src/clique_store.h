@@ -0,0 +1,434 @@
+#ifndef CLIQUE_STORE_H
+#define CLIQUE_STORE_H
+
+#include <bits/stdc++.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "adjacency.h"
+#include "async_output.h"
+
+using namespace std;
+
+// Binary clique store, little endian, in two files next to each other:
+//
+// <base>.cliques
+//   char     magic[8]              "BKCLQ\0\0\1"
+//   uint64   n, cliques, entries   vertices of the graph, cliques, their total size
+//   uint64   offsets[cliques + 1]  offsets[c]..offsets[c + 1] index vertices
+//   uint32   vertices[entries]     each clique's vertices, ascending
+//
+// <base>.postings
+//   char     magic[8]              "BKPST\0\0\1"
+//   uint64   n, cliques, entries   as in the clique file
+//   uint64   offsets[n + 1]        offsets[v]..offsets[v + 1] index clique_ids
+//   uint32   clique_ids[entries]   the cliques containing each vertex, ascending
+static const char CLIQUES_MAGIC[8] = {'B', 'K', 'C', 'L', 'Q', 0, 0, 1};
+static const char POSTINGS_MAGIC[8] = {'B', 'K', 'P', 'S', 'T', 0, 0, 1};
+
+struct CliqueFileHeader {
+    unsigned long long n;
+    unsigned long long cliques;
+    unsigned long long entries;
+};
+
+inline unsigned long long clique_file_bytes(unsigned long long rows, unsigned long long entries) {
+    return sizeof(CLIQUES_MAGIC) + sizeof(CliqueFileHeader) + (rows + 1) * sizeof(unsigned long long) +
+           entries * sizeof(unsigned);
+}
+
+// Runs f(t) for t in [0, threads) on its own thread each, or f(0) inline
+// with one thread, and waits for all of them
+template <class F>
+inline void parallel_for(int threads, F f) {
+    if (threads <= 1) {
+        f(0);
+        return;
+    }
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back([&f, t]() { f(t); });
+    for (auto& th : pool) th.join();
+}
+
+// A whole file mapped into memory, read-only or created at a given size
+class MappedFile {
+private:
+    int fd = -1;
+    char* bytes = nullptr;
+    size_t length = 0;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+
+    bool open(const string& filename) {
+        close();
+        fd = ::open(filename.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) return false;
+        length = st.st_size;
+        if (length == 0) return true;
+        void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return false;
+        bytes = (char*)p;
+        return true;
+    }
+
+    bool create(const string& filename, size_t size) {
+        close();
+        fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate(fd, size) != 0) return false;
+        length = size;
+        void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return false;
+        bytes = (char*)p;
+        return true;
+    }
+
+    // Unmaps and closes; false if the written pages could not be flushed
+    bool close() {
+        bool ok = true;
+        if (bytes) ok = munmap(bytes, length) == 0;
+        if (fd >= 0) ok = ::close(fd) == 0 && ok;
+        bytes = nullptr;
+        fd = -1;
+        length = 0;
+        return ok;
+    }
+
+    char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// The cliques one search thread finds, appended to its own spool file
+// through an AsyncOutput as [size, vertices...] records. The cliques of a
+// root are held back until the root completes, so a root cut short by the
+// stop flag leaves nothing behind, as it leaves no count.
+class CliqueSpool {
+private:
+    string path;
+    AsyncOutput out;
+    vector<unsigned> pending;
+    long long pending_cliques = 0;
+
+public:
+    long long cliques = 0;
+    long long entries = 0;
+    bool failed = false;
+
+    explicit CliqueSpool(const string& path) : path(path) {}
+
+    const string& file() const { return path; }
+
+    // ids maps the engine's vertex ids to the graph's (ego networks), or is null
+    void add(const vector<int>& clique, const vector<int>* ids) {
+        size_t start = pending.size() + 1;
+        pending.push_back(clique.size());
+        for (int u : clique) pending.push_back(ids ? (*ids)[u] : u);
+        sort(pending.begin() + start, pending.end());
+        pending_cliques++;
+    }
+
+    void commit() {
+        if (pending.empty()) return;
+        if (!out.is_open() && !out.open(path)) failed = true;
+        if (!failed) out.write((const char*)pending.data(), pending.size() * sizeof(unsigned));
+        cliques += pending_cliques;
+        entries += pending.size() - pending_cliques;
+        discard();
+    }
+
+    void discard() {
+        pending.clear();
+        pending_cliques = 0;
+    }
+
+    bool close() {
+        if (out.is_open() && !out.close()) failed = true;
+        return !failed;
+    }
+
+    bool used() const { return cliques > 0; }
+    const OutputStats& stats() const { return out.stats(); }
+};
+
+struct CliqueStoreStats {
+    long long cliques = 0;
+    long long entries = 0;
+    long long cliques_bytes = 0;
+    long long postings_bytes = 0;
+    long long merge_ns = 0;
+    long long index_ns = 0;
+    long long scratch_bytes = 0;  // per-thread posting counts
+    int threads = 1;
+    OutputStats spools;  // summed over the search threads
+};
+
+// Spools of the search threads (spool 0 for the main thread, t for parallel
+// worker t), merged at the end of the run into <base>.cliques and indexed
+// into <base>.postings. Both are written through shared mappings by up to
+// `threads` threads: the spools are copied side by side, and each thread
+// takes a range of clique ids, counts its postings per vertex, and fills
+// them in after the counts of the ranges before it, so every vertex's
+// clique ids come out ascending without sorting.
+class CliqueStore {
+private:
+    string base;
+    vector<unique_ptr<CliqueSpool>> spools;
+
+    static long long ns_since(chrono::steady_clock::time_point from) {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - from).count();
+    }
+
+    static void write_header(char* p, const char* magic, const CliqueFileHeader& header) {
+        memcpy(p, magic, 8);
+        memcpy(p + 8, &header, sizeof(header));
+    }
+
+public:
+    CliqueStore(const string& base, int num_spools) : base(base) {
+        for (int t = 0; t < num_spools; t++) spools.emplace_back(new CliqueSpool(base + ".cliques.spool" + to_string(t)));
+    }
+
+    static string cliques_path(const string& base) { return base + ".cliques"; }
+    static string postings_path(const string& base) { return base + ".postings"; }
+
+    CliqueSpool* spool(int t) { return spools[t].get(); }
+
+    // Buffers of the spools that were opened
+    long long buffer_bytes() const {
+        long long bytes = 0;
+        for (const auto& s : spools)
+            if (s->used()) bytes += AsyncOutput::buffer_bytes();
+        return bytes;
+    }
+
+    // Write the clique and postings files of a graph on n vertices and
+    // remove the spools; false, with a message on cerr, on an I/O error
+    bool finish(int n, int threads, CliqueStoreStats& s) {
+        s = CliqueStoreStats();
+        vector<long long> first_clique(spools.size() + 1, 0), first_entry(spools.size() + 1, 0);
+        bool ok = true;
+        for (size_t t = 0; t < spools.size(); t++) {
+            CliqueSpool& sp = *spools[t];
+            if (!sp.close()) {
+                cerr << "Error: Could not write " << sp.file() << endl;
+                ok = false;
+            }
+            first_clique[t + 1] = first_clique[t] + sp.cliques;
+            first_entry[t + 1] = first_entry[t] + sp.entries;
+            const OutputStats& io = sp.stats();
+            s.spools.bytes += io.bytes;
+            s.spools.buffers += io.buffers;
+            s.spools.write_ns += io.write_ns;
+            s.spools.stall_ns += io.stall_ns;
+            s.spools.stalls += io.stalls;
+        }
+        s.cliques = first_clique.back();
+        s.entries = first_entry.back();
+        s.threads = max(1, threads);
+        if (s.entries > UINT_MAX || s.cliques > UINT_MAX) {
+            cerr << "Error: the clique store holds at most 2^32 cliques and vertex entries" << endl;
+            ok = false;
+        }
+        if (!ok) {
+            for (const auto& sp : spools) remove(sp->file().c_str());
+            return false;
+        }
+
+        // Copy the spools into the clique file, one spool per thread at a time
+        auto start = chrono::steady_clock::now();
+        MappedFile cliques;
+        string cliques_file = cliques_path(base);
+        if (!cliques.create(cliques_file, clique_file_bytes(s.cliques, s.entries))) {
+            cerr << "Error: Could not create " << cliques_file << endl;
+            return false;
+        }
+        CliqueFileHeader header = {(unsigned long long)n, (unsigned long long)s.cliques, (unsigned long long)s.entries};
+        write_header(cliques.data(), CLIQUES_MAGIC, header);
+        unsigned long long* offsets = (unsigned long long*)(cliques.data() + sizeof(CLIQUES_MAGIC) + sizeof(header));
+        unsigned* vertices = (unsigned*)(offsets + s.cliques + 1);
+        offsets[s.cliques] = s.entries;
+        atomic<size_t> next_spool(0);
+        atomic<bool> read_failed(false);
+        parallel_for(min<int>(s.threads, spools.size()), [&](int) {
+            for (size_t t; (t = next_spool++) < spools.size();) {
+                if (spools[t]->cliques == 0) continue;
+                MappedFile in;
+                if (!in.open(spools[t]->file())) {
+                    read_failed = true;
+                    continue;
+                }
+                const unsigned* record = (const unsigned*)in.data();
+                unsigned long long entry = first_entry[t];
+                for (long long c = first_clique[t]; c < first_clique[t + 1]; c++) {
+                    unsigned size = *record++;
+                    offsets[c] = entry;
+                    memcpy(vertices + entry, record, size * sizeof(unsigned));
+                    record += size;
+                    entry += size;
+                }
+            }
+        });
+        for (const auto& sp : spools) remove(sp->file().c_str());
+        if (read_failed) {
+            cerr << "Error: Could not read back the clique spools" << endl;
+            return false;
+        }
+        s.cliques_bytes = cliques.size();
+        s.merge_ns = ns_since(start);
+
+        // Postings: per-thread counts of each vertex over a range of cliques
+        // of about equal total size
+        start = chrono::steady_clock::now();
+        MappedFile postings;
+        string postings_file = postings_path(base);
+        if (!postings.create(postings_file, clique_file_bytes(n, s.entries))) {
+            cerr << "Error: Could not create " << postings_file << endl;
+            return false;
+        }
+        write_header(postings.data(), POSTINGS_MAGIC, header);
+        unsigned long long* starts = (unsigned long long*)(postings.data() + sizeof(POSTINGS_MAGIC) + sizeof(header));
+        unsigned* ids = (unsigned*)(starts + n + 1);
+
+        int parts = s.threads;
+        vector<long long> part_first(parts + 1);
+        for (int t = 0; t <= parts; t++)
+            part_first[t] = upper_bound(offsets, offsets + s.cliques, (unsigned long long)(s.entries * t / parts)) - offsets;
+        part_first[0] = 0;
+        part_first[parts] = s.cliques;
+        vector<vector<unsigned>> counts(parts);
+        s.scratch_bytes = (long long)parts * n * sizeof(unsigned);
+        parallel_for(parts, [&](int t) {
+            counts[t].assign(n, 0);
+            for (unsigned long long e = offsets[part_first[t]]; e < offsets[part_first[t + 1]]; e++) counts[t][vertices[e]]++;
+        });
+        // Turn the counts into each part's start within the vertex's postings
+        parallel_for(parts, [&](int t) {
+            for (long long v = (long long)n * t / parts; v < (long long)n * (t + 1) / parts; v++) {
+                unsigned total = 0;
+                for (int p = 0; p < parts; p++) {
+                    unsigned c = counts[p][v];
+                    counts[p][v] = total;
+                    total += c;
+                }
+                starts[v + 1] = total;
+            }
+        });
+        starts[0] = 0;
+        for (int v = 0; v < n; v++) starts[v + 1] += starts[v];
+        parallel_for(parts, [&](int t) {
+            vector<unsigned>& cursor = counts[t];
+            for (long long c = part_first[t]; c < part_first[t + 1]; c++)
+                for (unsigned long long e = offsets[c]; e < offsets[c + 1]; e++) {
+                    unsigned v = vertices[e];
+                    ids[starts[v] + cursor[v]++] = c;
+                }
+        });
+        s.postings_bytes = postings.size();
+        bool closed = cliques.close();
+        if (!postings.close() || !closed) {
+            cerr << "Error: Could not write " << cliques_file << " and " << postings_file << endl;
+            return false;
+        }
+        s.index_ns = ns_since(start);
+        return true;
+    }
+};
+
+// Removes a store's two files when it goes out of scope, for a store that
+// only backs --cpm or --clique-graph
+class TemporaryCliqueStore {
+private:
+    string base;
+
+public:
+    explicit TemporaryCliqueStore(const string& base) : base(base) {}
+    TemporaryCliqueStore(const TemporaryCliqueStore&) = delete;
+    TemporaryCliqueStore& operator=(const TemporaryCliqueStore&) = delete;
+    ~TemporaryCliqueStore() {
+        remove(CliqueStore::cliques_path(base).c_str());
+        remove(CliqueStore::postings_path(base).c_str());
+    }
+};
+
+// Read access to a clique store through read-only mappings, for lookups
+// without loading the files. open() scans the offsets and ids once, so that
+// a corrupted store is rejected instead of read out of bounds.
+class CliqueIndex {
+private:
+    MappedFile cliques_file, postings_file;
+    CliqueFileHeader header = {0, 0, 0};
+    const unsigned long long* clique_offsets = nullptr;
+    const unsigned* clique_vertices = nullptr;
+    const unsigned long long* posting_offsets = nullptr;
+    const unsigned* posting_ids = nullptr;
+
+    static bool check(const MappedFile& f, const char* magic, unsigned long long rows, CliqueFileHeader& h) {
+        if (f.size() < sizeof(CLIQUES_MAGIC) + sizeof(h) || memcmp(f.data(), magic, 8)) return false;
+        memcpy(&h, f.data() + 8, sizeof(h));
+        if (rows == ULLONG_MAX) rows = h.cliques;
+        return rows < f.size() && h.entries < f.size() && f.size() == clique_file_bytes(rows, h.entries);
+    }
+
+    // Offsets start at 0, do not decrease and end at entries, and every id
+    // they index is below bound
+    static bool check_rows(const unsigned long long* offsets, unsigned long long rows, const unsigned* ids,
+                           unsigned long long entries, unsigned long long bound) {
+        if (offsets[0] != 0 || offsets[rows] != entries) return false;
+        for (unsigned long long r = 0; r < rows; r++)
+            if (offsets[r + 1] < offsets[r]) return false;
+        for (unsigned long long i = 0; i < entries; i++)
+            if (ids[i] >= bound) return false;
+        return true;
+    }
+
+public:
+    bool open(const string& base, string& error) {
+        CliqueFileHeader h;
+        string cliques_name = CliqueStore::cliques_path(base), postings_name = CliqueStore::postings_path(base);
+        if (!cliques_file.open(cliques_name) || !check(cliques_file, CLIQUES_MAGIC, ULLONG_MAX, header)) {
+            error = cliques_name + " is missing or not a clique file";
+            return false;
+        }
+        if (!postings_file.open(postings_name) || !check(postings_file, POSTINGS_MAGIC, header.n, h) || h.n != header.n ||
+            h.cliques != header.cliques || h.entries != header.entries) {
+            error = postings_name + " is missing or does not belong to " + cliques_name;
+            return false;
+        }
+        clique_offsets = (const unsigned long long*)(cliques_file.data() + sizeof(CLIQUES_MAGIC) + sizeof(header));
+        clique_vertices = (const unsigned*)(clique_offsets + header.cliques + 1);
+        posting_offsets = (const unsigned long long*)(postings_file.data() + sizeof(POSTINGS_MAGIC) + sizeof(header));
+        posting_ids = (const unsigned*)(posting_offsets + header.n + 1);
+        if (!check_rows(clique_offsets, header.cliques, clique_vertices, header.entries, header.n)) {
+            error = cliques_name + " is corrupted";
+            return false;
+        }
+        if (!check_rows(posting_offsets, header.n, posting_ids, header.entries, header.cliques)) {
+            error = postings_name + " is corrupted";
+            return false;
+        }
+        return true;
+    }
+
+    long long num_vertices() const { return header.n; }
+    long long num_cliques() const { return header.cliques; }
+    long long num_entries() const { return header.entries; }
+
+    Span<const unsigned> clique(long long id) const {
+        return Span<const unsigned>(clique_vertices + clique_offsets[id], clique_vertices + clique_offsets[id + 1]);
+    }
+
+    // Ids of the cliques containing v, ascending
+    Span<const unsigned> cliques_of(long long v) const {
+        return Span<const unsigned>(posting_ids + posting_offsets[v], posting_ids + posting_offsets[v + 1]);
+    }
+};
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef COMPRESSED_ADJACENCY_H
+#define COMPRESSED_ADJACENCY_H
+
+#include <bits/stdc++.h>
+
+#include "adjacency.h"
+#include "csr_io.h"
+#include "huge_pages.h"
+
+using namespace std;
+
+// Read-only neighbor lists, sorted and stored as gaps in group varint: each
+// group of up to four gaps is a control byte with their byte lengths (two
+// bits each, length - 1) followed by the gaps' little-endian bytes. That is
+// the layout SIMD decoders drive with a shuffle table per control byte; the
+// decoder here is scalar. A list starts with a LEB128 varint holding its
+// length and a raw flag, and its first gap is the neighbor itself.
+//
+// The longest lists, up to kRawShare of all entries, are stored raw as plain
+// 32-bit neighbors instead: ego networks are built by decoding the lists of
+// every later neighbor of a root, and hubs are later neighbors of many roots,
+// so on web-Google this 5% of the entries is 80% of the decoding work.
+//
+// Lists are located through a 64-bit base offset per block of 64 vertices
+// plus a 32-bit offset within the block, about 4 bytes per vertex instead of
+// the 8 of a plain CSR offset; a block's lists must stay under 4 GB.
+class CompressedAdjacency {
+private:
+    static const int kBlock = 64;
+    static constexpr double kRawShare = 0.05;
+    HugeVector<long long> block_offsets;
+    HugeVector<unsigned> offsets;  // of each list within its block
+    HugeVector<unsigned char> data;
+    int num_vertices = 0;
+    long long entries = 0;
+    int raw_degree = INT_MAX;  // lists at least this long are stored raw
+    long long raw_entries = 0;
+
+    static int byte_length(unsigned value) { return value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4; }
+
+    const unsigned char* list_start(int u) const { return data.data() + block_offsets[u / kBlock] + offsets[u]; }
+
+    // Header varint: length * 2 + raw flag
+    static unsigned read_header(const unsigned char*& p) {
+        unsigned header = 0;
+        for (int shift = 0;; shift += 7) {
+            unsigned char b = *p++;
+            header |= (unsigned)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return header;
+        }
+    }
+
+    // Smallest length whose lists, with all longer ones, hold at most
+    // kRawShare of the entries
+    void choose_raw_degree(vector<long long> lengths) {
+        long long total = accumulate(lengths.begin(), lengths.end(), 0LL);
+        sort(lengths.rbegin(), lengths.rend());
+        raw_degree = INT_MAX;
+        long long kept = 0;
+        for (size_t i = 0; i < lengths.size() && lengths[i] > 0; i++) {
+            kept += lengths[i];
+            if (kept > kRawShare * total) break;
+            if (i + 1 == lengths.size() || lengths[i + 1] < lengths[i]) raw_degree = lengths[i];
+        }
+    }
+
+    void clear() {
+        block_offsets.clear();
+        offsets.clear();
+        data.clear();
+        num_vertices = 0;
+        entries = 0;
+        raw_entries = 0;
+    }
+
+public:
+    int size() const { return num_vertices; }
+    int degree_of(int u) const {
+        const unsigned char* p = list_start(u);
+        return read_header(p) >> 1;
+    }
+    long long num_entries() const { return entries; }
+    long long num_raw_entries() const { return raw_entries; }
+    long long bytes() const {
+        return sizeof(long long) * block_offsets.capacity() + sizeof(unsigned) * offsets.capacity() + data.capacity();
+    }
+
+    // Append the next vertex's list; sorts it and drops repeats and self-loops
+    void append(vector<int>& neighbors) {
+        int u = num_vertices++;
+        sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        neighbors.erase(remove(neighbors.begin(), neighbors.end(), u), neighbors.end());
+        entries += neighbors.size();
+
+        if (u % kBlock == 0) block_offsets.push_back(data.size());
+        offsets.push_back(data.size() - block_offsets.back());
+        bool raw = (int)neighbors.size() >= raw_degree;
+        for (unsigned header = neighbors.size() * 2 + raw;; header >>= 7) {
+            data.push_back((header & 0x7f) | (header >= 0x80 ? 0x80 : 0));
+            if (header < 0x80) break;
+        }
+        if (raw) {
+            raw_entries += neighbors.size();
+            size_t pos = data.size();
+            data.resize(pos + sizeof(int) * neighbors.size());
+            memcpy(&data[pos], neighbors.data(), sizeof(int) * neighbors.size());
+            return;
+        }
+
+        int prev = 0;
+        for (size_t g = 0; g < neighbors.size(); g += 4) {
+            size_t control_pos = data.size();
+            data.push_back(0);
+            unsigned char control = 0;
+            for (size_t j = g; j < neighbors.size() && j < g + 4; j++) {
+                unsigned gap = neighbors[j] - prev;
+                prev = neighbors[j];
+                int len = byte_length(gap);
+                control |= (len - 1) << (2 * (j - g));
+                for (int b = 0; b < len; b++) data.push_back((gap >> (8 * b)) & 0xff);
+            }
+            data[control_pos] = control;
+        }
+    }
+
+    // After the last append: pad for the decoder's 4-byte loads
+    void finish() {
+        data.insert(data.end(), 3, 0);
+        data.shrink_to_fit();
+    }
+
+    // Calls f(neighbor) for every neighbor of u in ascending order. Gaps are
+    // read as unaligned 32-bit loads and masked to their length; data ends
+    // with padding so the loads never run past it.
+    template <class F>
+    void for_each(int u, F f) const {
+        static const unsigned masks[4] = {0xffu, 0xffffu, 0xffffffu, 0xffffffffu};
+        const unsigned char* p = list_start(u);
+        unsigned header = read_header(p);
+        int remaining = header >> 1;
+        if (header & 1) {
+            for (int j = 0; j < remaining; j++, p += sizeof(int)) {
+                int w;
+                memcpy(&w, p, sizeof(w));
+                f(w);
+            }
+            return;
+        }
+        unsigned value = 0;
+        while (remaining > 0) {
+            unsigned control = *p++;
+            int in_group = min(remaining, 4);
+            for (int j = 0; j < in_group; j++) {
+                unsigned len = (control >> (2 * j)) & 3;
+                unsigned gap;
+                memcpy(&gap, p, sizeof(gap));
+                value += gap & masks[len];
+                p += len + 1;
+                f((int)value);
+            }
+            remaining -= in_group;
+        }
+    }
+
+    void decode(int u, vector<int>& out) const {
+        out.clear();
+        for_each(u, [&](int w) { out.push_back(w); });
+    }
+
+    void build(const Adjacency& adj) {
+        clear();
+        vector<long long> lengths(adj.size());
+        for (int u = 0; u < adj.size(); u++) lengths[u] = adj[u].size();
+        choose_raw_degree(lengths);
+        vector<int> list;
+        for (int u = 0; u < adj.size(); u++) {
+            list.assign(adj[u].begin(), adj[u].end());
+            append(list);
+        }
+        finish();
+    }
+
+    // Compress a binary CSR file while streaming its neighbor array, so the
+    // plain adjacency is never held in memory
+    bool load_csr_file(const string& filename) {
+        ifstream in(filename, ios::binary);
+        CSRHeader header;
+        if (!read_csr_header(in, header)) return false;
+        vector<unsigned long long> file_offsets(header.n + 1);
+        if (!in.read((char*)file_offsets.data(), file_offsets.size() * sizeof(file_offsets[0])) ||
+            !valid_csr_offsets(file_offsets, header))
+            return false;
+
+        clear();
+        vector<long long> lengths(header.n);
+        for (unsigned long long u = 0; u < header.n; u++) lengths[u] = file_offsets[u + 1] - file_offsets[u];
+        choose_raw_degree(lengths);
+        offsets.reserve(header.n);
+        block_offsets.reserve(header.n / kBlock + 1);
+        vector<unsigned> raw;
+        vector<int> list;
+        for (unsigned long long u = 0; u < header.n; u++) {
+            raw.resize(file_offsets[u + 1] - file_offsets[u]);
+            if (!in.read((char*)raw.data(), raw.size() * sizeof(unsigned))) return false;
+            list.assign(raw.begin(), raw.end());
+            for (int w : list)
+                if (w < 0 || (unsigned long long)w >= header.n) return false;
+            append(list);
+        }
+        finish();
+        return true;
+    }
+};
+
+#endif
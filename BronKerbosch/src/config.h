@@ -0,0 +1,83 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Engine settings that depend on the input graph, as chosen by --autotune
+// and reloaded with --config. Stored as key=value lines; '#' starts a comment.
+struct EngineConfig {
+    bool degeneracy = true;  // ordering=degeneracy|natural
+    bool pivot_from_p = false;  // pivot=tomita|p-only
+    int grain = 64;  // roots claimed at once by a parallel worker
+    int hubs = 1024;  // highest-degree vertices given bitmap rows
+
+    string ordering_name() const { return degeneracy ? "degeneracy" : "natural"; }
+    string pivot_name() const { return pivot_from_p ? "p-only" : "tomita"; }
+
+    string describe() const {
+        return "ordering=" + ordering_name() + " pivot=" + pivot_name() + " grain=" + to_string(grain) + " hubs=" + to_string(hubs);
+    }
+
+    // Returns false with a message on cerr for an unknown key or value
+    bool set(const string& key, const string& value) {
+        if (key == "ordering" && (value == "degeneracy" || value == "natural")) {
+            degeneracy = value == "degeneracy";
+        } else if (key == "pivot" && (value == "tomita" || value == "p-only")) {
+            pivot_from_p = value == "p-only";
+        } else if (key == "grain" && atoi(value.c_str()) > 0) {
+            grain = atoi(value.c_str());
+        } else if (key == "hubs" && value.find_first_not_of("0123456789") == string::npos && !value.empty()) {
+            hubs = atoi(value.c_str());
+        } else {
+            cerr << "Invalid configuration entry " << key << "=" << value << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool load(const string& filename) {
+        ifstream in(filename);
+        if (!in.is_open()) {
+            cerr << "Error: Could not open file " << filename << " for reading." << endl;
+            return false;
+        }
+        string line;
+        while (getline(in, line)) {
+            line = line.substr(0, line.find('#'));
+            size_t eq = line.find('=');
+            if (line.find_first_not_of(" \t\r") == string::npos) continue;
+            if (eq == string::npos) {
+                cerr << "Invalid configuration line: " << line << "\n";
+                return false;
+            }
+            auto trim = [](string t) {
+                size_t b = t.find_first_not_of(" \t\r"), e = t.find_last_not_of(" \t\r");
+                return b == string::npos ? string() : t.substr(b, e - b + 1);
+            };
+            if (!set(trim(line.substr(0, eq)), trim(line.substr(eq + 1)))) return false;
+        }
+        return true;
+    }
+
+    void write(ostream& out) const {
+        out << "ordering=" << ordering_name() << "\n";
+        out << "pivot=" << pivot_name() << "\n";
+        out << "grain=" << grain << "\n";
+        out << "hubs=" << hubs << "\n";
+    }
+
+    bool save(const string& filename, const string& comment) const {
+        ofstream out(filename);
+        if (!out.is_open()) {
+            cerr << "Error: Could not open file " << filename << " for writing." << endl;
+            return false;
+        }
+        out << "# " << comment << "\n";
+        write(out);
+        return (bool)out;
+    }
+};
+
+#endif
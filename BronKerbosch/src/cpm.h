@@ -0,0 +1,355 @@
+#ifndef CPM_H
+#define CPM_H
+
+#include <bits/stdc++.h>
+
+#include "async_output.h"
+#include "clique_store.h"
+
+using namespace std;
+
+// Union-find over 32-bit ids that any number of threads may use at once:
+// parents are atomics, roots are linked with a compare-and-swap, the larger
+// id below the smaller (so a set's root is its smallest member), and finds
+// halve the path behind them with compare-and-swaps that may fail harmlessly.
+class ConcurrentUnionFind {
+private:
+    vector<atomic<unsigned>> parent;
+
+public:
+    explicit ConcurrentUnionFind(size_t n) : parent(n) {
+        for (size_t i = 0; i < n; i++) parent[i].store(i, memory_order_relaxed);
+    }
+
+    unsigned find(unsigned x) {
+        for (;;) {
+            unsigned p = parent[x].load(memory_order_acquire);
+            if (p == x) return x;
+            unsigned gp = parent[p].load(memory_order_acquire);
+            if (gp != p) parent[x].compare_exchange_weak(p, gp, memory_order_release, memory_order_relaxed);
+            x = gp;
+        }
+    }
+
+    // True if x and y were in different sets
+    bool unite(unsigned x, unsigned y) {
+        for (;;) {
+            x = find(x);
+            y = find(y);
+            if (x == y) return false;
+            if (x < y) swap(x, y);
+            unsigned expected = x;
+            if (parent[x].compare_exchange_strong(expected, y, memory_order_acq_rel, memory_order_relaxed)) return true;
+        }
+    }
+
+    long long bytes() const { return sizeof(atomic<unsigned>) * parent.size(); }
+};
+
+struct CpmStats {
+    int k = 0;
+    long long cliques = 0;  // of at least k vertices
+    long long grouped = 0;  // (vertex, clique) entries sorted into groups
+    long long scanning = 0;  // cliques joined by scanning postings instead
+    long long candidates = 0;  // clique pairs the scanning cliques met
+    long long checked = 0;  // of those, intersected; the rest were already joined
+    long long unions = 0;
+    long long communities = 0;
+    long long largest = 0;
+    long long covered = 0;  // vertices in at least one community
+    long long scratch_bytes = 0;
+    long long ns = 0;
+    int threads = 1;
+};
+
+// k-clique communities (clique percolation) from the maximal cliques of a
+// clique store: two k-clique communities are adjacent when they share k - 1
+// vertices, and on maximal cliques that means two cliques of at least k
+// vertices sharing a set S of k - 1 vertices (Palla et al.).
+//
+// Threads claim the vertices v and take the cliques containing v from its
+// postings: these share S when its smallest vertex is v. They are grouped
+// by their next vertex above v, each group by the next one above that, and
+// so on; a group at the k - 1-th vertex shares all of S and is joined in a
+// ConcurrentUnionFind. No pair of cliques is ever compared, but a clique
+// takes part in about C(|c|, k - 1) groups, so a clique for which that is
+// more than the postings it would scan instead is left out of the groups.
+// It looks for its neighbors d directly: d shares k - 1 of its vertices,
+// so misses at most |c| - k + 1 of them, and c only scans the postings of
+// its |c| - k + 2 vertices with the shortest lists. Pairs already in one set
+// are not intersected.
+//
+// The communities are the union of their cliques' vertices, written one per
+// line, largest first.
+class CliquePercolation {
+private:
+    static const int kVertexChunk = 64;
+    static const int kCliqueChunk = 1024;
+
+    struct Scratch {
+        vector<vector<pair<unsigned, unsigned>>> groups;  // per depth: (next vertex, clique)
+        vector<vector<unsigned>> families;  // per depth
+        vector<unsigned> seen;  // scanning: c + 1 once d was met from c
+        vector<pair<size_t, unsigned>> by_postings;
+        CpmStats stats;
+    };
+
+    const CliqueIndex& index;
+    int k;
+    ConcurrentUnionFind* sets = nullptr;
+    vector<char> scanning;
+
+    bool eligible(long long c) const { return (long long)index.clique(c).size() >= k; }
+
+    // At least k - 1 common vertices between two sorted cliques
+    bool overlaps(Span<const unsigned> a, Span<const unsigned> b) const {
+        long long need = k - 1;
+        const unsigned *i = a.begin(), *j = b.begin();
+        while (i != a.end() && j != b.end()) {
+            if (need > min(a.end() - i, b.end() - j)) return false;
+            if (*i < *j)
+                i++;
+            else if (*j < *i)
+                j++;
+            else {
+                if (--need == 0) return true;
+                i++;
+                j++;
+            }
+        }
+        return need <= 0;
+    }
+
+    // The |c| - k + 2 vertices of c with the shortest postings, and the
+    // length of those postings
+    long long pick_scan_vertices(Span<const unsigned> members, vector<pair<size_t, unsigned>>& by_postings) const {
+        by_postings.clear();
+        for (unsigned v : members) by_postings.push_back(make_pair(index.cliques_of(v).size(), v));
+        size_t scan = members.size() - k + 2;
+        partial_sort(by_postings.begin(), by_postings.begin() + scan, by_postings.end());
+        by_postings.resize(scan);
+        long long total = 0;
+        for (const auto& p : by_postings) total += p.first;
+        return total;
+    }
+
+    // Whether the cliques are all in one set already, so that no join
+    // among them can change anything
+    bool joined_already(const vector<unsigned>& family) const {
+        unsigned root = sets->find(family[0]);
+        for (size_t j = 1; j < family.size(); j++)
+            if (sets->find(family[j]) != root) return false;
+        return true;
+    }
+
+    // The cliques of family all contain an anchor of depth vertices, the
+    // largest of them after; join those sharing k - 1 - depth more vertices
+    // above it
+    void join_family(const vector<unsigned>& family, unsigned after, int depth, Scratch& s) {
+        if (joined_already(family)) return;
+        vector<pair<unsigned, unsigned>>& groups = s.groups[depth];
+        groups.clear();
+        int need = k - 1 - depth;
+        for (unsigned c : family) {
+            Span<const unsigned> members = index.clique(c);
+            const unsigned* first = upper_bound(members.begin(), members.end(), after);
+            // The next vertex leaves room for need - 1 more after it
+            for (const unsigned* w = first; w + need <= members.end(); w++) groups.push_back(make_pair(*w, c));
+        }
+        s.stats.grouped += groups.size();
+        sort(groups.begin(), groups.end());
+        for (size_t first = 0; first < groups.size();) {
+            size_t last = first + 1;
+            while (last < groups.size() && groups[last].first == groups[first].first) last++;
+            if (last - first >= 2 && need == 1) {
+                for (size_t j = first + 1; j < last; j++)
+                    if (sets->unite(groups[first].second, groups[j].second)) s.stats.unions++;
+            } else if (last - first >= 2) {
+                vector<unsigned>& sub = s.families[depth + 1];
+                sub.clear();
+                for (size_t j = first; j < last; j++) sub.push_back(groups[j].second);
+                join_family(sub, groups[first].first, depth + 1, s);
+            }
+            first = last;
+        }
+    }
+
+    // A scanning clique c against every other clique of at least k vertices;
+    // a pair of scanning cliques is left to the smaller
+    void scan_clique(unsigned c, Scratch& s) {
+        Span<const unsigned> members = index.clique(c);
+        pick_scan_vertices(members, s.by_postings);
+        for (const auto& p : s.by_postings) {
+            for (unsigned d : index.cliques_of(p.second)) {
+                if (d == c || s.seen[d] == c + 1) continue;
+                s.seen[d] = c + 1;
+                if (!eligible(d) || (scanning[d] && d < c)) continue;
+                s.stats.candidates++;
+                if (sets->find(c) == sets->find(d)) continue;
+                s.stats.checked++;
+                if (overlaps(members, index.clique(d)) && sets->unite(c, d)) s.stats.unions++;
+            }
+        }
+    }
+
+    static double binomial(long long n, long long r) {
+        double value = 1;
+        for (long long i = 1; i <= r; i++) value = value * (n - r + i) / i;
+        return value;
+    }
+
+public:
+    CliquePercolation(const CliqueIndex& index, int k) : index(index), k(k) {}
+
+    // Communities as sorted vertex lists, largest first
+    vector<vector<unsigned>> run(int threads, CpmStats& s) {
+        auto start = chrono::steady_clock::now();
+        s = CpmStats();
+        s.k = k;
+        s.threads = max(1, threads);
+        long long num_cliques = index.num_cliques();
+        long long n = index.num_vertices();
+        ConcurrentUnionFind joined(num_cliques);
+        sets = &joined;
+
+        // Which cliques scan postings instead of being grouped
+        scanning.assign(num_cliques, 0);
+        vector<Scratch> scratch(s.threads);
+        atomic<long long> next(0);
+        parallel_for(s.threads, [&](int t) {
+            Scratch& local = scratch[t];
+            for (long long first; (first = next.fetch_add(kCliqueChunk)) < num_cliques;)
+                for (long long c = first; c < min(first + kCliqueChunk, num_cliques); c++) {
+                    if (!eligible(c)) continue;
+                    local.stats.cliques++;
+                    Span<const unsigned> members = index.clique(c);
+                    if (binomial(members.size(), k - 1) > pick_scan_vertices(members, local.by_postings)) {
+                        scanning[c] = 1;
+                        local.stats.scanning++;
+                    }
+                }
+        });
+
+        // Group the other cliques by the vertices they share, from each
+        // vertex up
+        next = 0;
+        parallel_for(s.threads, [&](int t) {
+            Scratch& local = scratch[t];
+            local.groups.resize(k);
+            local.families.resize(k);
+            for (long long first; (first = next.fetch_add(kVertexChunk)) < n;)
+                for (long long v = first; v < min(first + kVertexChunk, n); v++) {
+                    vector<unsigned>& family = local.families[1];
+                    family.clear();
+                    for (unsigned c : index.cliques_of(v))
+                        if (eligible(c) && !scanning[c]) family.push_back(c);
+                    if (family.size() < 2) continue;
+                    if (k == 2) {
+                        for (size_t j = 1; j < family.size(); j++)
+                            if (joined.unite(family[0], family[j])) local.stats.unions++;
+                    } else {
+                        join_family(family, v, 1, local);
+                    }
+                }
+        });
+
+        // Then let the scanning cliques look for their neighbors
+        vector<unsigned> scanners;
+        for (long long c = 0; c < num_cliques; c++)
+            if (scanning[c]) scanners.push_back(c);
+        if (!scanners.empty()) {
+            next = 0;
+            parallel_for(s.threads, [&](int t) {
+                Scratch& local = scratch[t];
+                local.seen.assign(num_cliques, 0);
+                for (long long j; (j = next++) < (long long)scanners.size();) scan_clique(scanners[j], local);
+            });
+        }
+
+        s.scratch_bytes = joined.bytes() + num_cliques;
+        for (const Scratch& local : scratch) {
+            s.cliques += local.stats.cliques;
+            s.grouped += local.stats.grouped;
+            s.scanning += local.stats.scanning;
+            s.candidates += local.stats.candidates;
+            s.checked += local.stats.checked;
+            s.unions += local.stats.unions;
+            s.scratch_bytes += sizeof(unsigned) * local.seen.capacity();
+            for (const auto& g : local.groups) s.scratch_bytes += sizeof(g[0]) * g.capacity();
+        }
+
+        // Group the cliques of at least k vertices by set
+        vector<unsigned> root(num_cliques);
+        vector<long long> first_member;
+        vector<unsigned> members;
+        {
+            vector<long long> slot(num_cliques, -1);
+            vector<unsigned> roots;
+            for (long long c = 0; c < num_cliques; c++) {
+                if ((int)index.clique(c).size() < k) continue;
+                root[c] = joined.find(c);
+                if (slot[root[c]] < 0) {
+                    slot[root[c]] = roots.size();
+                    roots.push_back(root[c]);
+                }
+            }
+            first_member.assign(roots.size() + 1, 0);
+            for (long long c = 0; c < num_cliques; c++)
+                if ((int)index.clique(c).size() >= k) first_member[slot[root[c]] + 1]++;
+            for (size_t r = 0; r < roots.size(); r++) first_member[r + 1] += first_member[r];
+            members.resize(first_member.back());
+            vector<long long> fill(first_member.begin(), first_member.end() - 1);
+            for (long long c = 0; c < num_cliques; c++)
+                if ((int)index.clique(c).size() >= k) members[fill[slot[root[c]]]++] = c;
+        }
+
+        // Vertices of each community, in parallel over the communities
+        long long num_communities = first_member.size() - 1;
+        vector<vector<unsigned>> communities(num_communities);
+        atomic<long long> next_community(0);
+        parallel_for(s.threads, [&](int) {
+            for (long long r; (r = next_community++) < num_communities;) {
+                vector<unsigned>& vertices = communities[r];
+                for (long long j = first_member[r]; j < first_member[r + 1]; j++) {
+                    Span<const unsigned> clique = index.clique(members[j]);
+                    vertices.insert(vertices.end(), clique.begin(), clique.end());
+                }
+                sort(vertices.begin(), vertices.end());
+                vertices.erase(unique(vertices.begin(), vertices.end()), vertices.end());
+            }
+        });
+        sort(communities.begin(), communities.end(), [](const vector<unsigned>& a, const vector<unsigned>& b) {
+            return a.size() != b.size() ? a.size() > b.size() : a < b;
+        });
+
+        vector<bool> in_community(index.num_vertices(), false);
+        for (const auto& community : communities)
+            for (unsigned v : community) in_community[v] = true;
+        s.communities = num_communities;
+        s.largest = communities.empty() ? 0 : communities[0].size();
+        s.covered = count(in_community.begin(), in_community.end(), true);
+        s.ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        return communities;
+    }
+
+    // One community per line, its vertices separated by spaces
+    static bool write(const string& filename, const vector<vector<unsigned>>& communities, OutputStats& io) {
+        AsyncOutput out(filename);
+        if (!out.is_open()) {
+            cerr << "Error: Could not open file " << filename << " for writing." << endl;
+            return false;
+        }
+        for (const auto& community : communities) {
+            for (size_t i = 0; i < community.size(); i++) out << (i ? " " : "") << community[i];
+            out << '\n';
+        }
+        if (!out.close()) {
+            cerr << "Error: Could not write " << filename << endl;
+            return false;
+        }
+        io = out.stats();
+        return true;
+    }
+};
+
+#endif
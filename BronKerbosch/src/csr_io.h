@@ -0,0 +1,108 @@
+#ifndef CSR_IO_H
+#define CSR_IO_H
+
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Binary CSR graph file, little endian:
+//   char     magic[8]             "BKCSR\0\0\1"
+//   uint64   n, m                 vertices, undirected edges
+//   uint64   offsets[n + 1]       offsets[u]..offsets[u + 1] index neighbors
+//   uint32   neighbors[2 * m]     both directions of every edge
+static const char CSR_MAGIC[8] = {'B', 'K', 'C', 'S', 'R', 0, 0, 1};
+
+struct CSRHeader {
+    unsigned long long n;
+    unsigned long long m;
+};
+
+inline unsigned long long csr_offsets_pos() { return sizeof(CSR_MAGIC) + sizeof(CSRHeader); }
+
+inline unsigned long long csr_neighbors_pos(unsigned long long n) {
+    return csr_offsets_pos() + (n + 1) * sizeof(unsigned long long);
+}
+
+inline bool is_csr_file(const string& filename) {
+    ifstream in(filename, ios::binary);
+    char magic[sizeof(CSR_MAGIC)];
+    return in.read(magic, sizeof(magic)) && !memcmp(magic, CSR_MAGIC, sizeof(magic));
+}
+
+// Write an undirected simple graph given by its edge list (u != v, no repeats)
+inline bool write_csr_file(const string& filename, int n, const vector<pair<int, int>>& edges) {
+    ofstream out(filename, ios::binary);
+    if (!out.is_open()) {
+        cerr << "Error: Could not open file " << filename << " for writing." << endl;
+        return false;
+    }
+
+    vector<unsigned long long> offsets(n + 1, 0);
+    for (const auto& e : edges) {
+        offsets[e.first + 1]++;
+        offsets[e.second + 1]++;
+    }
+    for (int u = 0; u < n; u++) offsets[u + 1] += offsets[u];
+
+    vector<unsigned> neighbors(offsets[n]);
+    vector<unsigned long long> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto& e : edges) {
+        neighbors[fill[e.first]++] = e.second;
+        neighbors[fill[e.second]++] = e.first;
+    }
+
+    CSRHeader header = {(unsigned long long)n, (unsigned long long)edges.size()};
+    out.write(CSR_MAGIC, sizeof(CSR_MAGIC));
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)offsets.data(), offsets.size() * sizeof(offsets[0]));
+    out.write((const char*)neighbors.data(), neighbors.size() * sizeof(neighbors[0]));
+    return (bool)out;
+}
+
+// Read the magic and header, leaving in at the offsets. Fails unless the
+// file is exactly as long as the header says, so that arrays can be sized
+// from it.
+inline bool read_csr_header(ifstream& in, CSRHeader& header) {
+    char magic[sizeof(CSR_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, CSR_MAGIC, sizeof(magic)) ||
+        !in.read((char*)&header, sizeof(header)))
+        return false;
+    streampos body = in.tellg();
+    in.seekg(0, ios::end);
+    unsigned long long file_size = in.tellg();
+    in.seekg(body);
+    return header.n <= (unsigned long long)INT_MAX && header.m <= file_size &&
+           csr_neighbors_pos(header.n) + 2 * header.m * sizeof(unsigned) == file_size;
+}
+
+// Offsets start at 0, do not decrease and end at the neighbor count
+template <class Offsets>
+inline bool valid_csr_offsets(const Offsets& offsets, const CSRHeader& header) {
+    if (offsets[0] != 0 || (unsigned long long)offsets[header.n] != 2 * header.m) return false;
+    for (unsigned long long u = 0; u < header.n; u++)
+        if (offsets[u + 1] < offsets[u]) return false;
+    return true;
+}
+
+// Read a whole CSR file straight into offset and neighbor arrays (vectors
+// of 8- and 4-byte integers, e.g. the graph's flat adjacency)
+template <class Offsets, class Neighbors>
+inline bool read_csr_file(const string& filename, Offsets& offsets, Neighbors& neighbors, long long& num_edges) {
+    static_assert(sizeof(offsets[0]) == sizeof(unsigned long long) && sizeof(neighbors[0]) == sizeof(unsigned),
+                  "CSR arrays hold 64-bit offsets and 32-bit neighbors");
+    ifstream in(filename, ios::binary);
+    CSRHeader header;
+    if (!read_csr_header(in, header)) return false;
+
+    offsets.resize(header.n + 1);
+    neighbors.resize(2 * header.m);
+    if (!in.read((char*)offsets.data(), offsets.size() * sizeof(offsets[0])) ||
+        !in.read((char*)neighbors.data(), neighbors.size() * sizeof(neighbors[0])) || !valid_csr_offsets(offsets, header))
+        return false;
+    for (size_t i = 0; i < neighbors.size(); i++)
+        if ((unsigned long long)neighbors[i] >= header.n) return false;
+    num_edges = header.m;
+    return true;
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Mean of independent per-probe estimates with a normal 95% confidence
+// interval. Knuth estimates are heavy-tailed, so the interval is optimistic
+// when few probes reach the expensive subtrees.
+struct SampleMean {
+    double sum = 0;
+    double sum_sq = 0;
+    long long count = 0;
+
+    void add(double v) {
+        sum += v;
+        sum_sq += v * v;
+        count++;
+    }
+
+    double mean() const { return count ? sum / count : 0; }
+
+    double half_width() const {
+        if (count < 2) return mean();
+        double var = max(0.0, (sum_sq - sum * sum / count) / (count - 1));
+        return 1.96 * sqrt(var / count);
+    }
+
+    double low() const { return max(0.0, mean() - half_width()); }
+    double high() const { return mean() + half_width(); }
+};
+
+// One random root-to-leaf path. Every node on it stands for `weight` nodes
+// of the full tree, the product of the branching factors above it.
+struct ProbeResult {
+    double nodes = 0;
+    double cliques = 0;
+    double work = 0;         // sum of 1 + |X| + |P| over the nodes
+    double set_entries = 0;  // sum of |R| + |X| + |P|, written as ids by the tracked export
+    double children = 0;     // sum of child counts, written as ids by the tracked export
+};
+
+// Pre-run cost estimate: Knuth's estimator over the pivot recursion for the
+// untracked run, and over the tracked tree (every P candidate explored, as
+// the tracked export does for pivot-pruned ones) for the export size.
+struct SearchEstimate {
+    SampleMean nodes, cliques, work;
+    vector<ProbeResult> tracked;  // per tracked probe, kept whole for the export size
+    double ns_per_work = 0;  // calibrated on complete searches of sampled roots
+    long long calibration_roots = 0;
+    double elapsed_ms = 0;
+    int num_vertices = 0;
+
+    // Mean decimal length of the integers 0 .. n - 1
+    static double mean_digits(double n) {
+        if (n <= 1) return 1;
+        double total = 0;
+        for (double low = 1, d = 1; low < n; low *= 10, d++) total += (min(n, low * 10) - low) * d;
+        return (total + 1) / n;
+    }
+
+    SampleMean tracked_nodes() const {
+        SampleMean m;
+        for (const auto& r : tracked) m.add(r.nodes);
+        return m;
+    }
+
+    // Bytes of the tracked CSV: per row three node ids (own, parent,
+    // creation order), the candidate vertex, short counters, quotes, commas
+    // and the pruned flag, plus every vertex id of R, X and P and every
+    // child id with its separator
+    SampleMean export_bytes() const {
+        SampleMean bytes;
+        double id_digits = mean_digits(tracked_nodes().mean());
+        double vertex_digits = mean_digits(num_vertices);
+        double per_row = 3 * id_digits + vertex_digits + 28;
+        for (const auto& r : tracked)
+            bytes.add(r.nodes * per_row + r.set_entries * (vertex_digits + 1) + r.children * (id_digits + 1));
+        return bytes;
+    }
+
+    static string format_count(double v) {
+        ostringstream out;
+        if (v < 1e6)
+            out << fixed << setprecision(0) << v;
+        else
+            out << scientific << setprecision(2) << v;
+        return out.str();
+    }
+
+    static string format_bytes(double v) {
+        ostringstream out;
+        if (v >= 1e21) {
+            out << scientific << setprecision(2) << v << " B";
+            return out.str();
+        }
+        const char* units[] = {"B", "KB", "MB", "GB", "TB", "PB", "EB"};
+        int u = 0;
+        while (v >= 1024 && u < 6) {
+            v /= 1024;
+            u++;
+        }
+        out << fixed << setprecision(u ? 1 : 0) << v << ' ' << units[u];
+        return out.str();
+    }
+
+    static string format_duration(double ns) {
+        ostringstream out;
+        out << fixed << setprecision(1);
+        if (ns < 1e6)
+            out << ns / 1e3 << " us";
+        else if (ns < 1e9)
+            out << ns / 1e6 << " ms";
+        else if (ns < 3600e9)
+            out << ns / 1e9 << " s";
+        else if (ns < 86400e9 * 2)
+            out << ns / 3600e9 << " h";
+        else
+            out << ns / 86400e9 << " days";
+        return out.str();
+    }
+
+    template <class Format>
+    static void print_row(ostream& out, const char* name, const SampleMean& m, double scale, Format format) {
+        out << "  " << name << ": " << format(m.mean() * scale) << " (95% CI " << format(m.low() * scale) << " - "
+            << format(m.high() * scale) << ")\n";
+    }
+
+    void print(ostream& out) const {
+        out << "Search cost estimate (" << nodes.count << " probes, " << tracked.size() << " tracked probes, "
+            << calibration_roots << " calibration roots, " << fixed << setprecision(0) << elapsed_ms << defaultfloat
+            << " ms):\n";
+        print_row(out, "Search tree nodes", nodes, 1, format_count);
+        print_row(out, "Maximal cliques", cliques, 1, format_count);
+        if (ns_per_work > 0)
+            print_row(out, "Enumeration time", work, ns_per_work, format_duration);
+        else
+            out << "  Enumeration time: n/a (no calibration root finished)\n";
+        print_row(out, "Tracked tree nodes", tracked_nodes(), 1, format_count);
+        print_row(out, "Tracked export size", export_bytes(), 1, format_bytes);
+    }
+};
+
+#endif
@@ -0,0 +1,366 @@
+#ifndef EXTERNAL_CSR_H
+#define EXTERNAL_CSR_H
+
+#include <bits/stdc++.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "adjacency.h"
+#include "csr_io.h"
+
+using namespace std;
+
+// A binary CSR file (see csr_io.h) left on disk: only its offsets are held
+// in memory, and neighbor lists are read with pread as they are needed.
+class ExternalCSR {
+private:
+    string filename;
+    int fd = -1;
+    int num_vertices = 0;
+    long long num_edges = 0;
+    vector<unsigned long long> offsets;
+    unsigned long long neighbors_pos = 0;
+
+public:
+    ExternalCSR() {}
+    ExternalCSR(const ExternalCSR&) = delete;
+    ExternalCSR& operator=(const ExternalCSR&) = delete;
+    ~ExternalCSR() {
+        if (fd >= 0) close(fd);
+    }
+
+    bool open(const string& name) {
+        ifstream in(name, ios::binary);
+        char magic[sizeof(CSR_MAGIC)];
+        CSRHeader header;
+        if (!in.read(magic, sizeof(magic)) || memcmp(magic, CSR_MAGIC, sizeof(magic)) ||
+            !in.read((char*)&header, sizeof(header)) || header.n > (unsigned long long)INT_MAX)
+            return false;
+        offsets.resize(header.n + 1);
+        if (!in.read((char*)offsets.data(), offsets.size() * sizeof(offsets[0])) || offsets[header.n] != 2 * header.m)
+            return false;
+        for (unsigned long long u = 0; u < header.n; u++)
+            if (offsets[u + 1] < offsets[u]) return false;
+        fd = ::open(name.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        filename = name;
+        num_vertices = header.n;
+        num_edges = header.m;
+        neighbors_pos = csr_neighbors_pos(header.n);
+        return true;
+    }
+
+    const string& path() const { return filename; }
+    int size() const { return num_vertices; }
+    long long edges() const { return num_edges; }
+    int degree(int u) const { return offsets[u + 1] - offsets[u]; }
+    unsigned long long entry_offset(int u) const { return offsets[u]; }
+    long long metadata_bytes() const { return sizeof(unsigned long long) * offsets.capacity(); }
+
+    // Read entries [first, last) of the neighbor array
+    bool read_entries(unsigned long long first, unsigned long long last, unsigned* out) const {
+        char* p = (char*)out;
+        size_t left = (last - first) * sizeof(unsigned);
+        off_t pos = neighbors_pos + first * sizeof(unsigned);
+        while (left > 0) {
+            ssize_t got = pread(fd, p, left, pos);
+            if (got <= 0) return false;
+            p += got;
+            left -= got;
+            pos += got;
+        }
+        return true;
+    }
+
+    // Stream the lists in vertex order, f(u, Span<const int>), reading
+    // about chunk_bytes at a time
+    template <class F>
+    bool scan(F f, size_t chunk_bytes = 4 << 20) const {
+        return scan_where([](int) { return true; }, f, chunk_bytes) >= 0;
+    }
+
+    // As scan(), for the vertices u with selected(u) only; chunks without
+    // any are skipped. Returns the bytes read, or -1 on a read error.
+    template <class S, class F>
+    long long scan_where(S selected, F f, size_t chunk_bytes = 4 << 20) const {
+        vector<unsigned> buffer;
+        long long bytes = 0;
+        for (int first = 0; first < num_vertices;) {
+            int last = first + 1;
+            while (last < num_vertices && (offsets[last + 1] - offsets[first]) * sizeof(unsigned) <= chunk_bytes) last++;
+            int lo = first, hi = last;
+            while (lo < hi && !selected(lo)) lo++;
+            while (hi > lo && !selected(hi - 1)) hi--;
+            if (lo < hi) {
+                buffer.resize(offsets[hi] - offsets[lo]);
+                if (!read_entries(offsets[lo], offsets[hi], buffer.data())) return -1;
+                bytes += sizeof(unsigned) * buffer.size();
+                for (int u = lo; u < hi; u++) {
+                    if (!selected(u)) continue;
+                    const int* row = (const int*)buffer.data() + (offsets[u] - offsets[lo]);
+                    f(u, Span<const int>(row, row + degree(u)));
+                }
+            }
+            first = last;
+        }
+        return bytes;
+    }
+};
+
+// The lists a run of consecutive roots needs, in memory: each root's own
+// list and those of its neighbors after it in the root order, which is all
+// build_ego() reads. Lists are sorted, without repeats or self-loops; the
+// search indexes them by vertex (see Graph::run_external_roots).
+struct RowBatch {
+    vector<int> roots;  // ranks, in order
+    vector<int> vertices;  // whose lists are loaded, in load order
+    vector<long long> starts;  // list j is targets[starts[j], starts[j + 1])
+    vector<int> targets;
+
+    int size() const { return vertices.size(); }
+
+    Span<const int> list(int j) const { return Span<const int>(targets.data() + starts[j], targets.data() + starts[j + 1]); }
+
+    long long bytes() const {
+        return sizeof(int) * (roots.capacity() + vertices.capacity() + targets.capacity()) +
+               sizeof(long long) * starts.capacity();
+    }
+};
+
+// Totals of one external run
+struct ExternalStats {
+    long long batches = 0;
+    long long rows = 0;  // lists loaded, a vertex once per batch needing it
+    long long bytes_read = 0;
+    long long reads = 0;  // pread calls
+    long long io_ns = 0;  // I/O thread reading and preparing batches
+    long long stall_ns = 0;  // search waiting for a batch
+    long long peak_batch_bytes = 0;
+    bool failed = false;
+};
+
+// Passes of the external degeneracy ordering (see Graph::external_dgn_order)
+struct ExternalOrderStats {
+    int passes = 0;
+    long long bytes_read = 0;
+    int max_later = 0;  // most neighbors after a vertex in the order: a bound on |P| of a root
+    bool failed = false;
+};
+
+// Reads the row batches of the roots at the given ranks on an I/O thread,
+// at most kDepth batches ahead of the search, so that the search works on
+// one batch while the next is read. A batch first reads the lists of the
+// next roots, up to an eighth of batch_bytes, then grows root by root
+// until the lists of their later neighbors would pass batch_bytes (always
+// at least one root). Lists are read in file order, neighboring lists less
+// than kGapBytes apart in one pread of at most kMaxReadBytes.
+class RowPrefetcher {
+private:
+    static const int kDepth = 2;
+    static const long long kGapBytes = 4 << 10;
+    static const long long kMaxReadBytes = 1 << 20;
+    static const int kListOverhead = 3;  // vertex and start of a list, in 4-byte entries
+
+    const ExternalCSR& csr;
+    const vector<int>& rank;
+    const vector<int>& order;
+    const vector<int>& ranks;
+    long long batch_entries;
+
+    thread io;
+    mutex m;
+    condition_variable cv;
+    deque<unique_ptr<RowBatch>> ready;
+    vector<unique_ptr<RowBatch>> spare;
+    bool done = false;
+    bool stopping = false;
+    ExternalStats totals;
+
+    static long long ns_since(chrono::steady_clock::time_point from) {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - from).count();
+    }
+
+    // Sort, drop repeats and self-loops of the list just appended for u
+    static void clean_list(int u, vector<int>& targets, size_t begin) {
+        if (!is_sorted(targets.begin() + begin, targets.end())) sort(targets.begin() + begin, targets.end());
+        targets.erase(unique(targets.begin() + begin, targets.end()), targets.end());
+        auto self = lower_bound(targets.begin() + begin, targets.end(), u);
+        if (self != targets.end() && *self == u) targets.erase(self);
+    }
+
+    // Read the lists of the given sorted vertices in file order, merging
+    // reads across gaps under kGapBytes, and append them to b
+    bool read_lists(const vector<int>& vertices, RowBatch& b, vector<unsigned>& buffer, ExternalStats& s) {
+        for (size_t first = 0; first < vertices.size();) {
+            size_t last = first + 1;
+            auto gap = [&](size_t j) {
+                return (long long)(csr.entry_offset(vertices[j]) - csr.entry_offset(vertices[j - 1] + 1)) * (long long)sizeof(unsigned);
+            };
+            auto span = [&](size_t j) {
+                return (long long)(csr.entry_offset(vertices[j] + 1) - csr.entry_offset(vertices[first])) * (long long)sizeof(unsigned);
+            };
+            while (last < vertices.size() && gap(last) < kGapBytes && span(last) <= kMaxReadBytes) last++;
+            unsigned long long begin = csr.entry_offset(vertices[first]), end = csr.entry_offset(vertices[last - 1] + 1);
+            buffer.resize(end - begin);
+            if (!csr.read_entries(begin, end, buffer.data())) return false;
+            s.reads++;
+            s.bytes_read += sizeof(unsigned) * buffer.size();
+            for (size_t j = first; j < last; j++) {
+                int u = vertices[j];
+                size_t start = b.targets.size();
+                b.vertices.push_back(u);
+                b.starts.push_back(start);
+                for (unsigned long long e = csr.entry_offset(u); e < csr.entry_offset(u + 1); e++) {
+                    unsigned w = buffer[e - begin];
+                    if (w < (unsigned)csr.size()) b.targets.push_back(w);
+                }
+                clean_list(u, b.targets, start);
+            }
+            first = last;
+        }
+        s.rows += vertices.size();
+        return true;
+    }
+
+    bool fill(RowBatch& b, size_t& pos, vector<int>& stamp, int batch_id, vector<unsigned>& buffer, ExternalStats& s) {
+        b.roots.clear();
+        b.vertices.clear();
+        b.starts.clear();
+        b.targets.clear();
+
+        // Read the lists of the next roots, up to an eighth of the batch, in
+        // one pass; they decide which other lists are needed
+        vector<int> candidates;
+        long long root_entries = 0;
+        for (size_t j = pos; j < ranks.size(); j++) {
+            int v = order[ranks[j]];
+            if (!candidates.empty() && root_entries + csr.degree(v) + kListOverhead > batch_entries / 8) break;
+            if (stamp[v] != batch_id) {
+                stamp[v] = batch_id;
+                candidates.push_back(v);
+                root_entries += csr.degree(v) + kListOverhead;
+            }
+        }
+        sort(candidates.begin(), candidates.end());
+        b.vertices.reserve(candidates.size());
+        b.starts.reserve(candidates.size() + 1);
+        b.targets.reserve(root_entries);
+        if (!read_lists(candidates, b, buffer, s)) return false;
+        b.starts.push_back(b.targets.size());
+
+        // Take roots while their later neighbors' lists fit in the batch
+        vector<int> needed;
+        long long entries = root_entries;
+        while (pos < ranks.size()) {
+            int i = ranks[pos];
+            int v = order[i];
+            auto found = lower_bound(candidates.begin(), candidates.end(), v);
+            if (found == candidates.end() || *found != v) break;
+            Span<const int> neighbors = b.list(found - candidates.begin());
+            long long add = 0;
+            for (int w : neighbors)
+                if (rank[w] > i && stamp[w] != batch_id) add += csr.degree(w) + kListOverhead;
+            if (!b.roots.empty() && entries + add > batch_entries) break;
+            entries += add;
+            b.roots.push_back(i);
+            pos++;
+            for (int w : neighbors)
+                if (rank[w] > i && stamp[w] != batch_id) {
+                    stamp[w] = batch_id;
+                    needed.push_back(w);
+                }
+        }
+
+        sort(needed.begin(), needed.end());
+        b.starts.pop_back();
+        b.vertices.reserve(b.vertices.size() + needed.size());
+        b.starts.reserve(b.starts.size() + needed.size() + 1);
+        b.targets.reserve(b.targets.size() + entries - root_entries);
+        if (!read_lists(needed, b, buffer, s)) return false;
+        b.starts.push_back(b.targets.size());
+        return true;
+    }
+
+    void run() {
+        vector<int> stamp(csr.size(), 0);
+        vector<unsigned> buffer;
+        size_t pos = 0;
+        for (int batch_id = 1; pos < ranks.size(); batch_id++) {
+            unique_ptr<RowBatch> b;
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [&]() { return stopping || (int)ready.size() < kDepth; });
+                if (stopping) break;
+                if (!spare.empty()) {
+                    b = move(spare.back());
+                    spare.pop_back();
+                }
+            }
+            if (!b) b.reset(new RowBatch());
+            auto start = chrono::steady_clock::now();
+            ExternalStats s;
+            bool ok = fill(*b, pos, stamp, batch_id, buffer, s);
+            lock_guard<mutex> lock(m);
+            totals.io_ns += ns_since(start);
+            totals.rows += s.rows;
+            totals.reads += s.reads;
+            totals.bytes_read += s.bytes_read;
+            if (!ok) {
+                totals.failed = true;
+                break;
+            }
+            totals.batches++;
+            totals.peak_batch_bytes = max(totals.peak_batch_bytes, b->bytes());
+            ready.push_back(move(b));
+            cv.notify_all();
+        }
+        lock_guard<mutex> lock(m);
+        done = true;
+        cv.notify_all();
+    }
+
+public:
+    RowPrefetcher(const ExternalCSR& csr, const vector<int>& order, const vector<int>& rank, const vector<int>& ranks,
+                  long long batch_bytes)
+        : csr(csr), rank(rank), order(order), ranks(ranks), batch_entries(max(1LL, batch_bytes / (long long)sizeof(int))) {}
+
+    ~RowPrefetcher() { stop(); }
+
+    void start() { io = thread([this]() { run(); }); }
+
+    // The next batch, waiting for it if needed; false after the last one
+    bool next(unique_ptr<RowBatch>& b) {
+        auto start = chrono::steady_clock::now();
+        unique_lock<mutex> lock(m);
+        cv.wait(lock, [&]() { return done || !ready.empty(); });
+        totals.stall_ns += ns_since(start);
+        if (ready.empty()) return false;
+        b = move(ready.front());
+        ready.pop_front();
+        cv.notify_all();
+        return true;
+    }
+
+    // Hand a searched batch back for reuse of its buffers
+    void recycle(unique_ptr<RowBatch> b) {
+        lock_guard<mutex> lock(m);
+        spare.push_back(move(b));
+    }
+
+    void stop() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+            cv.notify_all();
+        }
+        if (io.joinable()) io.join();
+    }
+
+    ExternalStats stats() {
+        lock_guard<mutex> lock(m);
+        return totals;
+    }
+};
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Synthetic graphs for scaling experiments. Every generator cuts its work
+// into a fixed number of blocks with their own random streams derived from
+// the seed, so the graph depends only on the parameters and the seed, never
+// on the thread count. Edges come back as (u, v) with u < v, deduplicated.
+struct GeneratorParams {
+    string model;
+    int scale = 16;          // rmat: 2^scale vertices
+    int edge_factor = 16;    // rmat: edge_factor * 2^scale edge samples
+    double a = 0.57, b = 0.19, c = 0.19;  // rmat quadrant probabilities (Graph500)
+    int vertices = 1000;     // er, ba, planted, moon-moser
+    double prob = 0.01;      // er, planted: edge probability
+    int attach = 4;          // ba: edges per new vertex
+    int clique = 10;         // planted: size of the planted clique
+    unsigned long long seed = 1;
+    int threads = 1;
+};
+
+static const int GENERATOR_BLOCKS = 256;
+
+inline unsigned long long splitmix64(unsigned long long x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+inline unsigned long long block_seed(unsigned long long seed, int block) {
+    return splitmix64(seed ^ splitmix64(block + 1));
+}
+
+// Run gen(block, edges_of_block) for every block on the given threads and
+// concatenate the blocks' edges in block order
+template <class Gen>
+vector<pair<int, int>> generate_blocks(int threads, Gen gen) {
+    vector<vector<pair<int, int>>> parts(GENERATOR_BLOCKS);
+    atomic<int> next_block(0);
+    auto work = [&]() {
+        for (int b; (b = next_block.fetch_add(1)) < GENERATOR_BLOCKS;) gen(b, parts[b]);
+    };
+    vector<thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(work);
+    work();
+    for (auto& th : pool) th.join();
+
+    vector<pair<int, int>> edges;
+    for (auto& part : parts) edges.insert(edges.end(), part.begin(), part.end());
+    return edges;
+}
+
+// Orient every edge as u < v, drop self-loops and repeats
+inline void normalize_edges(vector<pair<int, int>>& edges) {
+    for (auto& e : edges)
+        if (e.first > e.second) swap(e.first, e.second);
+    edges.erase(remove_if(edges.begin(), edges.end(), [](const pair<int, int>& e) { return e.first == e.second; }),
+                edges.end());
+    sort(edges.begin(), edges.end());
+    edges.erase(unique(edges.begin(), edges.end()), edges.end());
+}
+
+// R-MAT / Kronecker: each edge descends `scale` levels of the adjacency
+// matrix, picking a quadrant with probabilities a, b, c, d
+inline vector<pair<int, int>> generate_rmat(const GeneratorParams& p) {
+    long long samples = (long long)p.edge_factor << p.scale;
+    return generate_blocks(p.threads, [&](int block, vector<pair<int, int>>& out) {
+        mt19937_64 rng(block_seed(p.seed, block));
+        uniform_real_distribution<double> uniform(0.0, 1.0);
+        long long first = samples * block / GENERATOR_BLOCKS, last = samples * (block + 1) / GENERATOR_BLOCKS;
+        for (long long i = first; i < last; i++) {
+            int u = 0, v = 0;
+            for (int level = 0; level < p.scale; level++) {
+                double r = uniform(rng);
+                int bit_u = r >= p.a + p.b;
+                int bit_v = (r >= p.a && r < p.a + p.b) || r >= p.a + p.b + p.c;
+                u = (u << 1) | bit_u;
+                v = (v << 1) | bit_v;
+            }
+            out.push_back(make_pair(u, v));
+        }
+    });
+}
+
+// Erdos-Renyi G(n, p) by geometric skipping over the pairs (u, w > u); block b
+// owns the rows u with u % GENERATOR_BLOCKS == b
+inline void append_gnp_rows(int block, int n, double prob, unsigned long long seed, vector<pair<int, int>>& out) {
+    if (prob <= 0) return;
+    mt19937_64 rng(block_seed(seed, block));
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    double log_q = log(1.0 - min(prob, 1.0 - 1e-12));
+    for (int u = block; u < n; u += GENERATOR_BLOCKS) {
+        long long w = u;
+        while (true) {
+            if (prob >= 1.0)
+                w++;
+            else
+                w += 1 + (long long)floor(log(1.0 - uniform(rng)) / log_q);
+            if (w >= n) break;
+            out.push_back(make_pair(u, (int)w));
+        }
+    }
+}
+
+inline vector<pair<int, int>> generate_erdos_renyi(const GeneratorParams& p) {
+    return generate_blocks(p.threads, [&](int block, vector<pair<int, int>>& out) {
+        append_gnp_rows(block, p.vertices, p.prob, p.seed, out);
+    });
+}
+
+// Barabasi-Albert preferential attachment, evaluated edge by edge: the
+// endpoint list M holds (source, target) of every edge, and the target of
+// edge i copies M[r] for a hashed r < 2i, so each edge resolves on its own by
+// following earlier copies. Vertices 0..attach form the seed clique.
+inline vector<pair<int, int>> generate_barabasi_albert(const GeneratorParams& p) {
+    int d = max(1, p.attach);
+    int n = max(p.vertices, d + 1);
+    vector<pair<int, int>> seed_edges;
+    for (int u = 0; u <= d; u++)
+        for (int v = u + 1; v <= d; v++) seed_edges.push_back(make_pair(u, v));
+    long long s = seed_edges.size();
+    long long total = s + (long long)(n - d - 1) * d;
+
+    auto endpoint = [&](long long k) {
+        // Follow copies until k names the source of an edge or a seed endpoint
+        while (k % 2 == 1 && (k - 1) / 2 >= s) {
+            long long i = (k - 1) / 2;
+            k = splitmix64(p.seed ^ splitmix64(i)) % (2 * i);
+        }
+        long long i = k / 2;
+        if (i < s) return k % 2 ? seed_edges[i].second : seed_edges[i].first;
+        return (int)(d + 1 + (i - s) / d);
+    };
+
+    return generate_blocks(p.threads, [&](int block, vector<pair<int, int>>& out) {
+        long long count = total - s;
+        long long first = s + count * block / GENERATOR_BLOCKS, last = s + count * (block + 1) / GENERATOR_BLOCKS;
+        if (block == 0) out = seed_edges;
+        for (long long i = first; i < last; i++) out.push_back(make_pair(endpoint(2 * i), endpoint(2 * i + 1)));
+    });
+}
+
+// G(n, p) plus a clique on `clique` vertices chosen by the seed
+inline vector<pair<int, int>> generate_planted_clique(const GeneratorParams& p) {
+    vector<pair<int, int>> edges = generate_erdos_renyi(p);
+    vector<int> perm(p.vertices);
+    for (int u = 0; u < p.vertices; u++) perm[u] = u;
+    mt19937_64 rng(splitmix64(p.seed));
+    shuffle(perm.begin(), perm.end(), rng);
+    int k = min(p.clique, p.vertices);
+    for (int i = 0; i < k; i++)
+        for (int j = i + 1; j < k; j++) edges.push_back(make_pair(perm[i], perm[j]));
+    return edges;
+}
+
+// Moon-Moser graph: complete multipartite with parts of size 3 (one part of
+// 4 or 2 absorbs the remainder), the worst case with 3^{n/3} maximal cliques
+inline vector<pair<int, int>> generate_moon_moser(const GeneratorParams& p) {
+    int n = p.vertices;
+    int parts = n / 3;
+    auto part = [&](int u) { return n % 3 == 1 ? min(u / 3, parts - 1) : u / 3; };
+    return generate_blocks(p.threads, [&](int block, vector<pair<int, int>>& out) {
+        for (int u = block; u < n; u += GENERATOR_BLOCKS)
+            for (int v = u + 1; v < n; v++)
+                if (part(u) != part(v)) out.push_back(make_pair(u, v));
+    });
+}
+
+// Range check of the parameters; returns the problem, or "" when they are
+// usable. Bounds keep vertex ids and sample counts within their types.
+inline string generator_param_error(const GeneratorParams& p) {
+    if (p.scale < 1 || p.scale > 30) return "--scale must be between 1 and 30";
+    if (p.edge_factor < 1) return "--edge-factor must be at least 1";
+    if (p.a < 0 || p.b < 0 || p.c < 0 || p.a + p.b + p.c > 1) return "--rmat a,b,c must be non-negative with a sum of at most 1";
+    if (p.vertices < 1) return "--vertices must be at least 1";
+    if (!(p.prob >= 0 && p.prob <= 1)) return "--prob must be between 0 and 1";
+    if (p.attach < 1) return "--attach must be at least 1";
+    if (p.clique < 0) return "--clique must not be negative";
+    return "";
+}
+
+// Number of vertices of the generated graph
+inline int generator_vertices(const GeneratorParams& p) {
+    if (p.model == "rmat") return 1 << p.scale;
+    if (p.model == "ba") return max(p.vertices, max(1, p.attach) + 1);
+    return p.vertices;
+}
+
+// Returns false for an unknown model
+inline bool generate_graph(const GeneratorParams& p, vector<pair<int, int>>& edges) {
+    if (p.model == "rmat")
+        edges = generate_rmat(p);
+    else if (p.model == "er")
+        edges = generate_erdos_renyi(p);
+    else if (p.model == "ba")
+        edges = generate_barabasi_albert(p);
+    else if (p.model == "planted")
+        edges = generate_planted_clique(p);
+    else if (p.model == "moon-moser")
+        edges = generate_moon_moser(p);
+    else
+        return false;
+    normalize_edges(edges);
+    return true;
+}
+
+inline bool write_edge_list(ostream& out, int n, const vector<pair<int, int>>& edges) {
+    out << n << ' ' << edges.size() << '\n';
+    for (const auto& e : edges) out << e.first << ' ' << e.second << '\n';
+    return (bool)out;
+}
+
+#endif
@@ -1,8 +1,26 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
 #include <bits/stdc++.h>
 
 #include <chrono>
 #include <fstream>
 
+#include "adjacency.h"
+#include "async_output.h"
+#include "clique_store.h"
+#include "compressed_adjacency.h"
+#include "csr_io.h"
+#include "estimator.h"
+#include "external_csr.h"
+#include "hub_rows.h"
+#include "instrumentation.h"
+#include "memory.h"
+#include "numa.h"
+#include "perf_counters.h"
+#include "run_control.h"
+#include "trace.h"
+
 using namespace std;
 
 // Structure to track search tree nodes
@@ -18,52 +36,300 @@ struct SearchTreeNode {
     vector<int> x_set;  // X set (excluded vertices)
     int candidate_vertex;  // the vertex being added to R
     bool pruned_by_pivot;  // true if this node would not be explored with pivoting
+    bool subtree_complete;  // false if the run stopped before this subtree was finished
+};
+
+// Counts over the search tree nodes already written to the spill file
+struct SpilledTreeTotals {
+    long long nodes = 0;
+    long long pruned = 0;
+    long long leaves = 0;
+    int max_depth = 0;
+    long long root_cliques = 0;
+    vector<int> roots;  // ids of spilled nodes without a parent
 };
 
 class Graph {
 private:
     int num_vertices;
     int num_edges;
-    vector<vector<int>> adj_list;
+    Adjacency adj_list;
+
+    // Compressed mode (see compressed_adjacency.h): the graph lives only in
+    // packed, shared read-only by the workers, and every root is searched on
+    // its ego network, decoded into the small per-thread graph ego. adj_list
+    // is then empty, except in ego itself.
+    shared_ptr<const CompressedAdjacency> packed;
+    shared_ptr<Graph> ego;
+    vector<int> ego_local;  // vertex -> 1 + position in the current root's neighborhood, or 0
+    vector<int> ego_rank;
+    vector<int> decoded;  // the current root's neighbors
+    vector<int> ego_vertex;  // local id -> vertex
+    vector<int> ego_degree;
+    vector<int> ego_edges;  // decoded P lists, local ids, X neighbors negated
+    vector<size_t> ego_run_end;
+    vector<long long> ego_cursor;
+
+    // External mode (see external_csr.h): the lists stay in the CSR file and
+    // only offsets and degrees are in memory. Roots are searched on ego
+    // networks as in compressed mode, built from the batch of lists an I/O
+    // thread has read for them.
+    shared_ptr<ExternalCSR> external;
+    long long external_batch_bytes = 64 << 20;
+    const RowBatch* batch = nullptr;
+    vector<int> batch_slot;  // vertex -> its list in batch, or -1
+    ExternalStats external_stats;
+    double external_epsilon = 0.1;
+    ExternalOrderStats external_order;
+    // Bitmap rows of the highest-degree vertices (see hub_rows.h), shared
+    // read-only by the workers; the kernels test hub adjacency there and
+    // leave hub lists unordered
+    shared_ptr<const HubRows> hub_rows;
     vector<int> degrees;
     int max_degree;
     vector<int> v_list;
-    vector<int> rev_idx;
+    HugeVector<int> rev_idx;
     vector<int> clique;
 
     // Search tree tracking
     vector<SearchTreeNode> search_tree_nodes;
     int node_counter;
-    bool track_search_tree;
+    bool track_search_tree = false;
+
+    // Memory accounting (see memory.h). Past tracking_budget bytes, finished
+    // search tree nodes are written to spill_path and dropped, so memory only
+    // holds the path from the root to the current node; the nodes finish in
+    // post-order, so the one finishing is always the last in search_tree_nodes
+    MemoryLedger* memory = nullptr;
+    long long tracking_budget = 0;  // 0 = unlimited
+    long long tracking_heap_bytes = 0;  // vectors owned by the tracked nodes
+    long long snapshot_bytes = 0;  // subproblems saved to expand pruned candidates
+    string spill_path;
+    shared_ptr<AsyncOutput> spill_out;  // shared so that worker copies stay copyable
+    bool tracking_spilled = false;
+    SpilledTreeTotals spilled;
+
+    // Hot-path instrumentation (see instrumentation.h)
+    bool count_hot_path = false;
+    HotPathCounters hot_path;
+    bool collect_stats = false;
+    SearchStats stats;
+
+    // Maximal cliques written to a clique store (see clique_store.h), through
+    // this thread's spool; clique_ids maps an ego network's vertices back
+    shared_ptr<CliqueStore> clique_store;
+    CliqueSpool* clique_spool = nullptr;
+    const vector<int>* clique_ids = nullptr;
+
+    // Per-root cost profile
+    bool profile_roots = false;
+    vector<RootProfile> root_profile;
+
+    // Timeline tracing (see trace.h); trace_tid identifies this worker's ring
+    TraceWriter* trace = nullptr;
+    int trace_tid = 0;
+
+    // Roots claimed at once by a parallel worker
+    int root_grain = 64;
+
+    // Pivot policy: Tomita's pivot from X and P, or from P only, which scans
+    // fewer lists per node but may prune less
+    bool pivot_from_p = false;
+
+    // Hardware counters of each parallel worker's enumeration loop
+    bool measure_thread_perf = false;
+    vector<PerfSample> thread_perf;
+
+    // Time split of each worker of the last parallel run
+    vector<WorkerLoad> worker_load;
+
+    // CPU and NUMA node each parallel worker is pinned to (empty: unpinned);
+    // a worker pins itself before copying the graph, so its copy and search
+    // state are first-touched on its own node
+    vector<int> worker_cpus;
+    vector<int> worker_nodes;
+
+    // Time limit and checkpointed progress (see run_control.h); aborted is
+    // set when the stop flag cut the current root short
+    RunControl* control = nullptr;
+    bool aborted = false;
 
 public:
     vector<int> dgn_order, rev_dgn;
-    int clique_count = 0;
+    long long clique_count = 0;
+    long long node_visits = 0;  // search tree nodes entered, pruned branches included
     int numVertices() const { return num_vertices; }
     int numEdges() const { return num_edges; }
 
-    const vector<int>& getNeighbors(int u) const {
+    Span<const int> getNeighbors(int u) const {
         return adj_list[u];
     }
 
-    int readGraph() {
-        if (!(cin >> num_vertices >> num_edges)) return 0;
-        adj_list.resize(num_vertices);
+    int readGraph(istream& in = cin) {
+        if (!(in >> num_vertices >> num_edges)) return 0;
+        vector<vector<int>> lists(num_vertices);
         degrees.resize(num_vertices, 0);
 
         int u, v;
         for (int i = 0; i < num_edges; i++) {
-            cin >> u >> v;
-            degrees[u]++;
-            degrees[v]++;
-            adj_list[u].push_back(v);
-            adj_list[v].push_back(u);
+            in >> u >> v;
+            lists[u].push_back(v);
+            lists[v].push_back(u);
+        }
+        adj_list.assign(lists);
+        finalize_adjacency();
+        return 1;
+    }
+
+    // Read a graph file in either the text edge list or the binary CSR format,
+    // optionally into compressed lists (a CSR file is compressed as it is read)
+    int readGraphFile(const string& filename, bool compress = false) {
+        if (is_csr_file(filename) && compress) {
+            shared_ptr<CompressedAdjacency> lists(new CompressedAdjacency());
+            if (!lists->load_csr_file(filename)) return 0;
+            set_packed(lists);
+            return 1;
+        }
+        if (is_csr_file(filename)) {
+            long long m;
+            if (!read_csr_file(filename, adj_list.offsets, adj_list.targets, m)) return 0;
+            num_vertices = adj_list.size();
+            num_edges = m;
+            degrees.assign(num_vertices, 0);
+            finalize_adjacency();
+            return 1;
+        }
+        ifstream in(filename);
+        if (!in.is_open()) return 0;
+        if (!readGraph(in)) return 0;
+        if (compress) compress_adjacency();
+        return 1;
+    }
+
+    // Replace the adjacency lists by their compressed form
+    void compress_adjacency() {
+        shared_ptr<CompressedAdjacency> lists(new CompressedAdjacency());
+        lists->build(adj_list);
+        adj_list = Adjacency();
+        set_packed(lists);
+    }
+
+    void set_packed(const shared_ptr<const CompressedAdjacency>& lists) {
+        packed = lists;
+        num_vertices = packed->size();
+        num_edges = packed->num_entries() / 2;
+        degrees.resize(num_vertices);
+        max_degree = 0;
+        for (int u = 0; u < num_vertices; u++) {
+            degrees[u] = packed->degree_of(u);
+            max_degree = max(max_degree, degrees[u]);
+        }
+    }
+
+    bool is_compressed() const { return (bool)packed; }
+
+    // Leave the graph in a binary CSR file, reading lists in batches of about
+    // batch_bytes during the search
+    int openExternal(const string& filename, long long batch_bytes) {
+        shared_ptr<ExternalCSR> csr(new ExternalCSR());
+        if (!csr->open(filename)) return 0;
+        external = csr;
+        external_batch_bytes = batch_bytes;
+        num_vertices = csr->size();
+        num_edges = csr->edges();
+        degrees.resize(num_vertices);
+        max_degree = 0;
+        for (int u = 0; u < num_vertices; u++) {
+            degrees[u] = csr->degree(u);
+            max_degree = max(max_degree, degrees[u]);
+        }
+        return 1;
+    }
+
+    bool is_external() const { return (bool)external; }
+
+    void set_external_batch_bytes(long long bytes) { external_batch_bytes = bytes; }
+
+    long long get_external_batch_bytes() const { return external_batch_bytes; }
+
+    // I/O of the last external run
+    const ExternalStats& external_run_stats() const { return external_stats; }
+
+    void set_external_epsilon(double epsilon) { external_epsilon = epsilon; }
+
+    // Passes and I/O of the last external ordering
+    const ExternalOrderStats& external_order_stats() const { return external_order; }
+
+    // Give up to about count vertices of the highest degree bitmap rows
+    // (ties at the threshold degree are all included), none of degree below
+    // HubRows::kMinDegree; none with count = 0. Not for compressed mode,
+    // whose ego networks are small.
+    void build_hub_rows(int count) {
+        hub_rows.reset();
+        if (count <= 0 || packed || external) return;
+        shared_ptr<HubRows> rows(new HubRows());
+        rows->build(adj_list, max<int>(HubRows::kMinDegree, HubRows::degree_of_top(degrees, count)));
+        if (!rows->empty()) hub_rows = rows;
+    }
+
+    const HubRows* hubs() const { return hub_rows.get(); }
+
+    int hub_slot(int u) const { return hub_rows ? hub_rows->slot(u) : -1; }
+
+    // Calls f(neighbor) for every neighbor of u, in any representation; in
+    // external mode u must be in the current batch
+    template <class F>
+    void for_each_neighbor(int u, F f) const {
+        if (packed)
+            packed->for_each(u, f);
+        else if (batch)
+            for (int w : batch->list(batch_slot[u])) f(w);
+        else if (!external)
+            for (int w : adj_list[u]) f(w);
+    }
+
+    // Calls f(u, neighbors) for every vertex in order, in external mode
+    // streaming the lists from the file; false on a read error
+    template <class F>
+    bool for_each_list(F f) const {
+        if (external && !packed) return external->scan(f);
+        vector<int> list;
+        for (int u = 0; u < num_vertices; u++) {
+            if (!packed) {
+                f(u, adj_list[u]);
+                continue;
+            }
+            packed->decode(u, list);
+            f(u, Span<const int>(list.data(), list.data() + list.size()));
         }
+        return true;
+    }
+
+    // Drop self-loops and repeated edges (e.g. twitter.txt lists some edges
+    // twice), keeping the first occurrence order, and compute degrees
+    void finalize_adjacency() {
+        vector<int> last_seen(num_vertices, -1);
+        auto& offsets = adj_list.offsets;
+        auto& targets = adj_list.targets;
+        long long write = 0;
+        for (int u = 0; u < num_vertices; u++) {
+            long long begin = offsets[u], end = offsets[u + 1];
+            offsets[u] = write;
+            for (long long read = begin; read < end; read++) {
+                int w = targets[read];
+                if (w == u || last_seen[w] == u) continue;
+                last_seen[w] = u;
+                targets[write++] = w;
+            }
+            degrees[u] = write - offsets[u];
+        }
+        offsets[num_vertices] = write;
+        targets.resize(write);
+        num_edges = write / 2;
 
         max_degree = 0;
         for (int i = 0; i < num_vertices; i++)
             max_degree = max(max_degree, degrees[i]);
-        return 1;
     }
 
     void printGraph() {
@@ -72,14 +338,17 @@ public:
 
         for (int u = 0; u < num_vertices; u++) {
             cout << u << ":";
-            for (int v : adj_list[u]) {
-                cout << ' ' << v;
-            }
+            for_each_neighbor(u, [](int v) { cout << ' ' << v; });
             cout << "\n";
         }
     }
 
     void dgn_order_cal() {
+        if (external) {
+            external_dgn_order();
+            return;
+        }
+        dgn_order.clear();
         vector<list<int>> D(max_degree + 1);
         vector<list<int>::iterator> it(num_vertices);
         vector<int> cur_deg(degrees);
@@ -94,22 +363,294 @@ public:
                 dgn_order.push_back(v);
                 D[i].erase(D[i].begin());
                 cur_deg[v] = 0;
-                for (int u : adj_list[v])
+                for_each_neighbor(v, [&](int u) {
                     if (cur_deg[u] != 0) {
                         D[cur_deg[u]].erase(it[u]);
                         D[--cur_deg[u]].push_back(u);
                         it[u] = prev(D[cur_deg[u]].end());
                     }
+                });
                 i -= 2;
             }
         }
 
         rev_dgn.resize(num_vertices);
         for (int i = 0; i < num_vertices; i++) rev_dgn[dgn_order[i]] = i;
+        if (memory) {
+            memory->set(MemoryLedger::ORDERING, ordering_bytes());
+            memory->touch(MemoryLedger::ORDERING, ordering_scratch_bytes());
+        }
     }
 
-    int bron_kerbosch_pivot(int x_idx, int p_idx, int e_idx, int depth = 0, int parent_node_id = -1, int cand_vertex = -1, bool is_pruned = false) {
+    // Approximate degeneracy order in external mode, peeling in rounds with
+    // only the degrees in memory: each round removes every vertex whose
+    // remaining degree is at most (1 + epsilon) times the average, ordered
+    // by that degree, then streams the removed vertices' lists once to
+    // update their neighbors. At least a fraction epsilon / (1 + epsilon) of
+    // the vertices go per round, so there are O(log n / epsilon) passes,
+    // and no vertex has more than 2 (1 + epsilon) times the degeneracy
+    // later neighbors.
+    void external_dgn_order() {
+        dgn_order.clear();
+        external_order = ExternalOrderStats();
+        vector<int> cur_deg(degrees);
+        vector<char> state(num_vertices, 0);  // 0 remaining, 1 removed this round, 2 removed
+        vector<int> round;
+        long long remaining = num_vertices, degree_sum = 0;
+        for (int d : degrees) degree_sum += d;
+        while (remaining > 0) {
+            double threshold = (1 + external_epsilon) * degree_sum / remaining;
+            round.clear();
+            for (int v = 0; v < num_vertices; v++)
+                if (state[v] == 0 && cur_deg[v] <= threshold) round.push_back(v);
+            stable_sort(round.begin(), round.end(), [&](int a, int b) { return cur_deg[a] < cur_deg[b]; });
+            for (int v : round) {
+                state[v] = 1;
+                dgn_order.push_back(v);
+                external_order.max_later = max(external_order.max_later, cur_deg[v]);
+            }
+            remaining -= round.size();
+
+            // A removed vertex's remaining neighbors lose it; its own
+            // remaining degree leaves the sum with it
+            for (int v : round) degree_sum -= cur_deg[v];
+            long long bytes = external->scan_where([&](int u) { return state[u] == 1; },
+                                                   [&](int u, Span<const int> neighbors) {
+                                                       for (int w : neighbors)
+                                                           if (w >= 0 && w < num_vertices && w != u && state[w] == 0) {
+                                                               cur_deg[w]--;
+                                                               degree_sum--;
+                                                           }
+                                                   });
+            if (bytes < 0) {
+                external_order.failed = true;
+                bytes = 0;
+            }
+            external_order.bytes_read += bytes;
+            external_order.passes++;
+            for (int v : round) state[v] = 2;
+        }
+
+        rev_dgn.resize(num_vertices);
+        for (int i = 0; i < num_vertices; i++) rev_dgn[dgn_order[i]] = i;
+        if (memory) {
+            memory->set(MemoryLedger::ORDERING, ordering_bytes());
+            memory->touch(MemoryLedger::ORDERING,
+                          (long long)num_vertices * (sizeof(int) + sizeof(char) + sizeof(int)));
+        }
+    }
+
+    // Bytes of the adjacency lists and degrees
+    long long graph_bytes() const {
+        return adj_list.bytes() + (packed ? packed->bytes() : 0) + (hub_rows ? hub_rows->bytes() : 0) +
+               (external ? external->metadata_bytes() : 0) +
+               sizeof(int) * degrees.capacity();
+    }
+
+    long long ordering_bytes() const { return sizeof(int) * (dgn_order.capacity() + rev_dgn.capacity()); }
+
+    // Bucket lists, iterators and degrees dgn_order_cal() holds while peeling
+    long long ordering_scratch_bytes() const {
+        return sizeof(list<int>) * (max_degree + 1LL) +
+               (long long)num_vertices * (sizeof(int) + 2 * sizeof(void*) + sizeof(list<int>::iterator) + sizeof(int));
+    }
+
+    // rev_idx, v_list and the clique of one enumerating thread
+    long long search_state_bytes() const {
+        return sizeof(int) * (2LL * num_vertices + max_degree + 1) + (packed ? sizeof(int) * (long long)num_vertices : 0) +
+               (external ? 2LL * sizeof(int) * num_vertices : 0);
+    }
+
+    // What each parallel worker copies (see run_root_ranks); before the
+    // ordering is computed, with_ordering adds its arrays
+    long long worker_bytes(bool with_ordering) const {
+        return sizeof(Graph) + graph_bytes() - (packed ? packed->bytes() : 0) - (hub_rows ? hub_rows->bytes() : 0) +
+               search_state_bytes() +
+               (with_ordering && dgn_order.empty() ? 2LL * sizeof(int) * num_vertices : ordering_bytes());
+    }
+
+    long long root_profile_bytes() const { return sizeof(RootProfile) * root_profile.capacity(); }
+
+    // Engine kernels of bron_kerbosch_pivot. The current subproblem occupies
+    // v_list[x_idx, e_idx): X is [x_idx, p_idx) and P is [p_idx, e_idx), and
+    // every adjacency list of a vertex in it starts with its neighbors in P,
+    // so scans stop at the first neighbor outside P. Hub lists are the
+    // exception: hub adjacency is looked up in hub_rows instead, and hub
+    // lists are left in any order. They are public so that
+    // bench/microbench.cpp can time them in isolation.
+
+    // Vertex of X and P (of P alone with pivot_from_p) with the most
+    // neighbors in P
+    template <bool kCountHotPath>
+    int select_pivot(int x_idx, int p_idx, int e_idx) {
+        int pivot = -1;
+        int _max_degree = -1;
+        int first = (pivot_from_p && p_idx < e_idx) ? p_idx : x_idx;
+        for (int i = first; i < e_idx; i++) {
+            int v = v_list[i];
+            int n_v = 0;
+            int hub = hub_slot(v);
+            if (hub >= 0) {
+                for (int j = p_idx; j < e_idx; j++) n_v += hub_rows->contains(hub, v_list[j]);
+                if (kCountHotPath) hot_path.pivot_scans += e_idx - p_idx + 1;
+            } else {
+                for (int u : adj_list[v]) {
+                    if (rev_idx[u] < p_idx || rev_idx[u] >= e_idx)
+                        break;
+                    n_v++;
+                }
+                if (kCountHotPath) hot_path.pivot_scans += n_v + 1;
+            }
+            if (n_v > _max_degree) {
+                pivot = v_list[i];
+                _max_degree = n_v;
+            }
+        }
+        return pivot;
+    }
+
+    // Move the neighbors of cand in X to the end of X; returns how many there are
+    template <bool kCountHotPath>
+    int partition_x(int cand, int x_idx, int p_idx, int e_idx) {
+        int num_x = 0;
+        int cand_hub = hub_slot(cand);
+        for (int j = p_idx - 1; j >= x_idx; j--) {
+            int _is_neighbor = 0;
+            int hub = hub_slot(v_list[j]);
+            if (hub >= 0 || cand_hub >= 0) {
+                if (kCountHotPath) hot_path.x_scans++;
+                _is_neighbor = hub >= 0 ? hub_rows->contains(hub, cand) : hub_rows->contains(cand_hub, v_list[j]);
+            } else {
+                for (int v : adj_list[v_list[j]]) {
+                    if (kCountHotPath) hot_path.x_scans++;
+                    if (rev_idx[v] < p_idx || rev_idx[v] >= e_idx) break;
+                    if (v == cand) {
+                        _is_neighbor = 1;
+                        break;
+                    }
+                }
+            }
+            if (_is_neighbor) {
+                num_x++;
+                rev_idx[v_list[j]] = p_idx - num_x;
+                rev_idx[v_list[p_idx - num_x]] = j;
+                swap(v_list[j], v_list[p_idx - num_x]);
+            }
+        }
+        return num_x;
+    }
+
+    // Move the neighbors of cand in P to the front of P; returns how many there are
+    template <bool kCountHotPath>
+    int partition_p(int cand, int p_idx, int e_idx) {
+        int num_p = 0;
+        int cand_hub = hub_slot(cand);
+        for (int j = p_idx; j < e_idx; j++) {
+            int _is_neighbor = 0;
+            int hub = hub_slot(v_list[j]);
+            if (hub >= 0 || cand_hub >= 0) {
+                if (kCountHotPath) hot_path.p_scans++;
+                _is_neighbor = hub >= 0 ? hub_rows->contains(hub, cand) : hub_rows->contains(cand_hub, v_list[j]);
+            } else {
+                for (int v : adj_list[v_list[j]]) {
+                    if (kCountHotPath) hot_path.p_scans++;
+                    if (rev_idx[v] < p_idx || rev_idx[v] >= e_idx) break;
+                    if (v == cand) {
+                        _is_neighbor = 1;
+                        break;
+                    }
+                }
+            }
+            if (_is_neighbor) {
+                rev_idx[v_list[j]] = p_idx + num_p;
+                rev_idx[v_list[p_idx + num_p]] = j;
+                swap(v_list[j], v_list[p_idx + num_p]);
+                num_p++;
+            }
+        }
+        return num_p;
+    }
+
+    // Bring the neighbors in the child P [p_idx, p_idx + num_p) to the front
+    // of the adjacency lists of the child's vertices
+    template <bool kCountHotPath>
+    void reorder_for_child(int p_idx, int e_idx, int num_x, int num_p) {
+        for (int i = p_idx - num_x; i < p_idx + num_p; i++) {
+            if (hub_slot(v_list[i]) >= 0) continue;
+            auto neighbors = adj_list[v_list[i]];
+            int write = 0;
+
+            for (int read = 0; read < (int)neighbors.size(); ++read) {
+                int w = neighbors[read];
+                if (kCountHotPath) hot_path.reorder_steps++;
+                if (rev_idx[w] < p_idx || rev_idx[w] >= e_idx)
+                    break;
+
+                if (rev_idx[w] >= p_idx && rev_idx[w] < p_idx + num_p) {
+                    std::swap(neighbors[write], neighbors[read]);
+                    ++write;
+                }
+            }
+        }
+    }
+
+    // Move cand to the end of the P-prefix of the child's adjacency lists,
+    // ready for cand to leave P. The rest of the prefix keeps its order, so
+    // later pivot ties break differently than with the earlier erase and
+    // insert: tracked trees have the same node total and cliques, but their
+    // order and the explored/pruned/leaf split can differ (political-books:
+    // 543/2007/1203 instead of 544/2006/1202).
+    template <bool kCountHotPath>
+    void restore_after_child(int cand, int p_idx, int e_idx, int num_x, int num_p) {
+        for (int i = p_idx - num_x; i < p_idx + num_p; i++) {
+            if (hub_slot(v_list[i]) >= 0) continue;
+            auto neighbors = adj_list[v_list[i]];
+            int pos = -1;
+            int end = 0;
+            for (; end < (int)neighbors.size(); ++end) {
+                int w = neighbors[end];
+                if (kCountHotPath) hot_path.restore_steps++;
+                if (rev_idx[w] < p_idx || rev_idx[w] >= e_idx)
+                    break;
+                if (w == cand) pos = end;
+            }
+            if (pos >= 0)
+                rotate(neighbors.begin() + pos, neighbors.begin() + pos + 1, neighbors.begin() + end);
+        }
+    }
+
+    // Flag the neighbors of pivot among P = v_list[p_idx, e_idx)
+    void mark_pivot_neighbors(int pivot, int p_idx, int e_idx, vector<bool>& pivot_neigh) const {
+        int hub = hub_slot(pivot);
+        if (hub >= 0) {
+            for (int i = p_idx; i < e_idx; i++) pivot_neigh[i - p_idx] = hub_rows->contains(hub, v_list[i]);
+            return;
+        }
+        for (int v : adj_list[pivot]) {
+            if (rev_idx[v] < p_idx || rev_idx[v] >= e_idx) break;
+            pivot_neigh[rev_idx[v] - p_idx] = true;
+        }
+    }
+
+    int bron_kerbosch_pivot(int x_idx, int p_idx, int e_idx) {
+        if (count_hot_path) {
+            if (collect_stats) return bron_kerbosch_pivot_impl<true, true>(x_idx, p_idx, e_idx);
+            return bron_kerbosch_pivot_impl<true, false>(x_idx, p_idx, e_idx);
+        }
+        if (collect_stats) return bron_kerbosch_pivot_impl<false, true>(x_idx, p_idx, e_idx);
+        return bron_kerbosch_pivot_impl<false, false>(x_idx, p_idx, e_idx);
+    }
+
+    template <bool kCountHotPath, bool kCollectStats>
+    int bron_kerbosch_pivot_impl(int x_idx, int p_idx, int e_idx, int depth = 0, int parent_node_id = -1, int cand_vertex = -1, bool is_pruned = false) {
+        if (control && control->stopped()) {
+            aborted = true;
+            return 0;
+        }
         int current_node_id = -1;
+        node_visits++;
+        if (kCountHotPath) hot_path.count_call(depth);
+        if (kCollectStats) stats.record_node(depth, e_idx - p_idx, p_idx - x_idx);
 
         // Track this node if enabled
         if (track_search_tree) {
@@ -117,7 +658,7 @@ public:
             SearchTreeNode node;
             node.node_id = current_node_id;
             node.parent_id = parent_node_id;
-            node.creation_order = search_tree_nodes.size();
+            node.creation_order = current_node_id;
             node.depth = depth;
             node.current_clique = clique;
 
@@ -134,42 +675,37 @@ public:
             node.candidate_vertex = cand_vertex;
             node.cliques_in_subtree = 0;
             node.pruned_by_pivot = is_pruned;
-            search_tree_nodes.push_back(node);
+            node.subtree_complete = false;
+            tracking_heap_bytes += node_heap_bytes(node);
+            search_tree_nodes.push_back(move(node));
 
             // Add this node as a child of parent
-            if (parent_node_id >= 0 && parent_node_id < search_tree_nodes.size()) {
-                search_tree_nodes[parent_node_id].children_ids.push_back(current_node_id);
+            if (parent_node_id >= 0) {
+                tracked_node(parent_node_id).children_ids.push_back(current_node_id);
+                tracking_heap_bytes += sizeof(int);
             }
+            update_tracking_memory();
         }
 
         if (x_idx == p_idx && p_idx == e_idx) {
             // Only count cliques if not in a pruned branch
             if (!is_pruned) {
                 clique_count++;
+                if (clique_spool) clique_spool->add(clique, clique_ids);
             }
             if (track_search_tree && current_node_id >= 0) {
-                search_tree_nodes[current_node_id].cliques_in_subtree = 1;
+                SearchTreeNode& node = tracked_node(current_node_id);
+                node.cliques_in_subtree = 1;
+                node.subtree_complete = true;
+                finish_tracked_node();
             }
+            if (kCollectStats) stats.record_maximal_leaf();
             return 1;  // Return number of cliques found
         }
 
         int total_cliques = 0;
 
-        int pivot = -1;
-        int _max_degree = -1;
-        for (int i = x_idx; i < e_idx; i++) {
-            int v = v_list[i];
-            int n_v = 0;
-            for (int u : adj_list[v]) {
-                if (rev_idx[u] < p_idx || rev_idx[u] >= e_idx)
-                    break;
-                n_v++;
-            }
-            if (n_v > _max_degree) {
-                pivot = v_list[i];
-                _max_degree = n_v;
-            }
-        }
+        int pivot = select_pivot<kCountHotPath>(x_idx, p_idx, e_idx);
 
         // Collect all P candidates (without pivot pruning)
         vector<int> all_p_candidates;
@@ -179,10 +715,7 @@ public:
 
         // Collect pivot neighbors to determine pruned candidates
         vector<bool> pivot_neigh(e_idx - p_idx);
-        for (int v : adj_list[pivot]) {
-            if (rev_idx[v] < p_idx || rev_idx[v] >= e_idx) break;
-            pivot_neigh[rev_idx[v] - p_idx] = true;
-        }
+        mark_pivot_neighbors(pivot, p_idx, e_idx, pivot_neigh);
 
         // Separate candidates into pruned and non-pruned
         vector<int> r_candidates;  // Non-pruned (will be explored)
@@ -196,79 +729,20 @@ public:
         }
         int num_candidates = r_candidates.size();
         pivot_neigh.clear();
+        if (kCollectStats) stats.record_branching(num_candidates, pruned_candidates.size());
 
         for (int cand : r_candidates) {
-            int num_x = 0;
-            for (int j = p_idx - 1; j >= x_idx; j--) {
-                int _is_neighbor = 0;
-                for (int v : adj_list[v_list[j]]) {
-                    if (rev_idx[v] < p_idx || rev_idx[v] >= e_idx) break;
-                    if (v == cand) {
-                        _is_neighbor = 1;
-                        break;
-                    }
-                }
-                if (_is_neighbor) {
-                    num_x++;
-                    rev_idx[v_list[j]] = p_idx - num_x;
-                    rev_idx[v_list[p_idx - num_x]] = j;
-                    swap(v_list[j], v_list[p_idx - num_x]);
-                }
-            }
-
-            int num_p = 0;
-            for (int j = p_idx; j < e_idx; j++) {
-                int _is_neighbor = 0;
-                for (int v : adj_list[v_list[j]]) {
-                    if (rev_idx[v] < p_idx || rev_idx[v] >= e_idx) break;
-                    if (v == cand) {
-                        _is_neighbor = 1;
-                        break;
-                    }
-                }
-                if (_is_neighbor) {
-                    rev_idx[v_list[j]] = p_idx + num_p;
-                    rev_idx[v_list[p_idx + num_p]] = j;
-                    swap(v_list[j], v_list[p_idx + num_p]);
-                    num_p++;
-                }
-            }
-
-            for (int i = p_idx - num_x; i < p_idx + num_p; i++) {
-                auto& neighbors = adj_list[v_list[i]];
-                int write = 0;
-
-                for (int read = 0; read < (int)neighbors.size(); ++read) {
-                    int w = neighbors[read];
-                    if (rev_idx[w] < p_idx || rev_idx[w] >= e_idx)
-                        break;
-
-                    if (rev_idx[w] >= p_idx && rev_idx[w] < p_idx + num_p) {
-                        std::swap(neighbors[write], neighbors[read]);
-                        ++write;
-                    }
-                }
-            }
+            int num_x = partition_x<kCountHotPath>(cand, x_idx, p_idx, e_idx);
+            int num_p = partition_p<kCountHotPath>(cand, p_idx, e_idx);
+            reorder_for_child<kCountHotPath>(p_idx, e_idx, num_x, num_p);
 
             clique.push_back(cand);
-            int subtree_cliques = bron_kerbosch_pivot(p_idx - num_x, p_idx, p_idx + num_p, depth + 1, current_node_id, cand, false);
+            int subtree_cliques = bron_kerbosch_pivot_impl<kCountHotPath, kCollectStats>(p_idx - num_x, p_idx, p_idx + num_p, depth + 1, current_node_id, cand, false);
             total_cliques += subtree_cliques;
             clique.pop_back();
+            if (aborted) return total_cliques;  // layout is rebuilt by prepare_root
 
-            for (int i = p_idx - num_x; i < p_idx + num_p; i++) {
-                for (auto it = adj_list[v_list[i]].begin();;) {
-                    if (it == adj_list[v_list[i]].end() || rev_idx[*it] < p_idx || rev_idx[*it] >= e_idx) {
-                        adj_list[v_list[i]].insert(it, cand);
-                        break;
-                    }
-                    int w = *it;
-                    if (w == cand) {
-                        it++;
-                        adj_list[v_list[i]].erase(prev(it));
-                    } else
-                        it++;
-                }
-            }
+            restore_after_child<kCountHotPath>(cand, p_idx, e_idx, num_x, num_p);
 
             rev_idx[v_list[p_idx]] = rev_idx[cand];
             rev_idx[cand] = p_idx;
@@ -285,186 +759,697 @@ public:
         // Explore pruned candidates (only if tracking enabled)
         // These are explored to show what would have been searched without pivot
         if (track_search_tree && current_node_id >= 0) {
-            // Save current state
-            vector<int> saved_v_list = v_list;
-            vector<int> saved_rev_idx = rev_idx;
-            vector<vector<int>> saved_adj_list = adj_list;
+            // Save the subproblem: the descendants only reorder v_list and
+            // rev_idx within [x_idx, e_idx) and the adjacency lists of its
+            // vertices, so the rest of the graph need not be copied
+            vector<int> saved_v_list(v_list.begin() + x_idx, v_list.begin() + e_idx);
+            vector<vector<int>> saved_adj_lists(e_idx - x_idx);
+            long long saved_bytes = sizeof(int) * saved_v_list.size();
+            for (int i = x_idx; i < e_idx; i++) {
+                saved_adj_lists[i - x_idx].assign(adj_list[v_list[i]].begin(), adj_list[v_list[i]].end());
+                saved_bytes += sizeof(vector<int>) + sizeof(int) * saved_adj_lists[i - x_idx].size();
+            }
+            snapshot_bytes += saved_bytes;
+            update_tracking_memory();
+            auto restore_subproblem = [&]() {
+                for (int i = x_idx; i < e_idx; i++) {
+                    int u = saved_v_list[i - x_idx];
+                    v_list[i] = u;
+                    rev_idx[u] = i;
+                    copy(saved_adj_lists[i - x_idx].begin(), saved_adj_lists[i - x_idx].end(), adj_list[u].begin());
+                }
+            };
 
             for (int cand : pruned_candidates) {
                 // Restore state for each pruned candidate
-                v_list = saved_v_list;
-                rev_idx = saved_rev_idx;
-                adj_list = saved_adj_list;
+                restore_subproblem();
 
                 // Compute X' and P' for the pruned candidate
-                int num_x = 0;
-                for (int j = p_idx - 1; j >= x_idx; j--) {
-                    int _is_neighbor = 0;
-                    for (int v : adj_list[v_list[j]]) {
-                        if (rev_idx[v] < p_idx || rev_idx[v] >= e_idx)
-                            break;
-                        if (v == cand) {
-                            _is_neighbor = 1;
-                            break;
-                        }
-                    }
-                    if (_is_neighbor) {
-                        num_x++;
-                        rev_idx[v_list[j]] = p_idx - num_x;
-                        rev_idx[v_list[p_idx - num_x]] = j;
-                        swap(v_list[j], v_list[p_idx - num_x]);
-                    }
-                }
-
-                int num_p = 0;
-                for (int j = p_idx; j < e_idx; j++) {
-                    int _is_neighbor = 0;
-                    for (int v : adj_list[v_list[j]]) {
-                        if (rev_idx[v] < p_idx || rev_idx[v] >= e_idx)
-                            break;
-                        if (v == cand) {
-                            _is_neighbor = 1;
-                            break;
-                        }
-                    }
-                    if (_is_neighbor) {
-                        rev_idx[v_list[j]] = p_idx + num_p;
-                        rev_idx[v_list[p_idx + num_p]] = j;
-                        swap(v_list[j], v_list[p_idx + num_p]);
-                        num_p++;
-                    }
-                }
-
-                for (int i = p_idx - num_x; i < p_idx + num_p; i++) {
-                    auto& neighbors = adj_list[v_list[i]];
-                    int write = 0;
-
-                    for (int read = 0; read < (int)neighbors.size(); ++read) {
-                        int w = neighbors[read];
-                        if (rev_idx[w] < p_idx || rev_idx[w] >= e_idx)
-                            break;
-
-                        if (rev_idx[w] >= p_idx && rev_idx[w] < p_idx + num_p) {
-                            std::swap(neighbors[write], neighbors[read]);
-                            ++write;
-                        }
-                    }
-                }
+                int num_x = partition_x<kCountHotPath>(cand, x_idx, p_idx, e_idx);
+                int num_p = partition_p<kCountHotPath>(cand, p_idx, e_idx);
+                reorder_for_child<kCountHotPath>(p_idx, e_idx, num_x, num_p);
 
                 clique.push_back(cand);
-                bron_kerbosch_pivot(p_idx - num_x, p_idx, p_idx + num_p, depth + 1, current_node_id, cand, true);
+                bron_kerbosch_pivot_impl<kCountHotPath, kCollectStats>(p_idx - num_x, p_idx, p_idx + num_p, depth + 1, current_node_id, cand, true);
                 clique.pop_back();
+                if (aborted) break;
             }
 
             // Restore original state after all pruned candidates
-            v_list = saved_v_list;
-            rev_idx = saved_rev_idx;
-            adj_list = saved_adj_list;
+            restore_subproblem();
+            snapshot_bytes -= saved_bytes;
+            update_tracking_memory();
         }
 
         if (track_search_tree && current_node_id >= 0) {
-            search_tree_nodes[current_node_id].cliques_in_subtree = total_cliques;
+            SearchTreeNode& node = tracked_node(current_node_id);
+            node.cliques_in_subtree = total_cliques;
+            node.subtree_complete = !aborted;
+            if (!aborted) finish_tracked_node();
         }
 
         return total_cliques;
     }
 
-    // Basic Bron-Kerbosch without degeneracy ordering
-    void bron_kerbosch_basic() {
-        rev_idx.clear();
-        rev_idx.resize(num_vertices, -1);
-
-        // Start with R = {}, P = all vertices, X = {}
-        // We iterate over all vertices (similar to degeneracy but in natural order)
-        for (int i = 0; i < num_vertices; i++) {
-            int v = i;
-            vector<int> P, X;
-
-            // For basic version without degeneracy:
-            // X = neighbors with index < i
-            // P = neighbors with index > i
-            for (int u : adj_list[v]) {
-                if (u < i)
-                    X.push_back(u);
-                else
-                    P.push_back(u);
+    // Lay out the root subproblem of v, the i-th vertex in the root order:
+    // X = neighbors ranked before v, P = neighbors ranked after v. v_list
+    // holds X then P, and every adjacency list of a vertex in them starts
+    // with its neighbors in P. Returns |X|; finish_root() undoes rev_idx.
+    int prepare_root(int v, int i, const vector<int>& rank) {
+        if ((int)rev_idx.size() != num_vertices) rev_idx.assign(num_vertices, -1);
+
+        v_list.clear();
+        for (int u : adj_list[v])
+            if (rank[u] < i) v_list.push_back(u);
+        int x_size = v_list.size();
+        for (int u : adj_list[v])
+            if (rank[u] >= i) v_list.push_back(u);
+
+        for (int j = 0; j < v_list.size(); j++) rev_idx[v_list[j]] = j;
+
+        for (int u : v_list) {
+            if (hub_slot(u) >= 0) continue;
+            auto neighbors = adj_list[u];
+            int write = 0;
+
+            for (int read = 0; read < (int)neighbors.size(); ++read) {
+                int w = neighbors[read];
+                if (rev_idx[w] >= x_size && rev_idx[w] < v_list.size()) {
+                    std::swap(neighbors[write], neighbors[read]);
+                    ++write;
+                }
             }
+        }
+        return x_size;
+    }
 
-            v_list.clear();
-            v_list.insert(v_list.end(), X.begin(), X.end());
-            v_list.insert(v_list.end(), P.begin(), P.end());
+    void finish_root() {
+        for (int j = 0; j < v_list.size(); j++) {
+            rev_idx[v_list[j]] = -1;
+        }
+    }
 
-            for (int j = 0; j < v_list.size(); j++) rev_idx[v_list[j]] = j;
+    const vector<int>& root_vertices() const { return v_list; }
 
-            for (int u : v_list) {
-                auto& neighbors = adj_list[u];
-                int write = 0;
+    // Expand the root subproblem of v, the i-th vertex in the root order
+    void search_root(int v, int i, const vector<int>& rank) {
+        chrono::steady_clock::time_point root_start;
+        long long nodes_before = node_visits;
+        long long cliques_before = clique_count;
+        if (profile_roots) root_start = chrono::steady_clock::now();
+        long long trace_start = trace ? trace->now() : 0;
 
-                for (int read = 0; read < (int)neighbors.size(); ++read) {
-                    int w = neighbors[read];
-                    if (rev_idx[w] >= X.size() && rev_idx[w] < v_list.size()) {
-                        std::swap(neighbors[write], neighbors[read]);
-                        ++write;
-                    }
-                }
-            }
+        int x_size = prepare_root(v, i, rank);
+        int p_size = v_list.size() - x_size;
 
-            clique.push_back(v);
-            bron_kerbosch_pivot(0, X.size(), v_list.size());
-            clique.pop_back();
+        clique.push_back(v);
+        aborted = false;
+        bron_kerbosch_pivot(0, x_size, v_list.size());
+        clique.pop_back();
+
+        finish_root();
+
+        // A root cut short by the stop flag counts as not searched
+        if (aborted) {
+            clique_count = cliques_before;
+            node_visits = nodes_before;
+            if (clique_spool) clique_spool->discard();
+            return;
+        }
+        if (clique_spool) clique_spool->commit();
+        if (control) control->complete(i, clique_count - cliques_before, node_visits - nodes_before);
+
+        if (profile_roots) {
+            RootProfile rp;
+            rp.rank = i;
+            rp.vertex = v;
+            rp.p_size = p_size;
+            rp.x_size = x_size;
+            rp.nodes = node_visits - nodes_before;
+            rp.cliques = clique_count - cliques_before;
+            rp.ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - root_start).count();
+            root_profile.push_back(rp);
+        }
+        if (trace) trace->record(trace_tid, "root", trace_start, trace->now(), v, i);
+    }
+
+    // Expand every root in the given order. With more than one thread, each
+    // worker owns a copy of the graph, since the engine reorders adjacency
+    // lists in place, and claims root_grain consecutive roots at a time from a
+    // shared counter; the workers' results are merged back into this graph.
+    void run_roots(const vector<int>& order, const vector<int>& rank, int num_threads) {
+        vector<int> ranks;
+        for (int i = 0; i < num_vertices; i++)
+            if (!control || !control->is_done(i)) ranks.push_back(i);
+        run_root_ranks(order, rank, ranks, num_threads);
+    }
 
-            for (int j = 0; j < v_list.size(); j++) {
-                rev_idx[v_list[j]] = -1;
+    // Expand the roots at the given positions of the order, in that sequence
+    void run_root_ranks(const vector<int>& order, const vector<int>& rank, const vector<int>& ranks, int num_threads) {
+        int num_roots = ranks.size();
+        worker_load.clear();
+        if (external) {
+            run_external_roots(order, rank, ranks);
+            return;
+        }
+        if (num_threads <= 1) {
+            rev_idx.clear();
+            rev_idx.resize(num_vertices, -1);
+            if (memory) memory->set(MemoryLedger::SEARCH_STATE, search_state_bytes());
+            for (int i : ranks) {
+                if (control && control->stopped()) break;
+                expand_root(order[i], i, rank);
             }
+            flush_ego();
+            return;
+        }
+
+        if (trace) trace->ensure_threads(num_threads + 1);
+        if (memory) memory->set(MemoryLedger::WORKERS, num_threads * worker_bytes(false));
+        atomic<int> next_root(0);
+        vector<unique_ptr<Graph>> workers(num_threads);
+        vector<PerfSample> worker_perf(num_threads);
+        vector<WorkerLoad> loads(num_threads);
+        auto ns_since = [](chrono::steady_clock::time_point from) {
+            return (long long)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - from).count();
+        };
+        auto phase_start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&, t]() {
+                WorkerLoad& load = loads[t];
+                if (!worker_cpus.empty()) {
+                    load.cpu = worker_cpus[t % worker_cpus.size()];
+                    load.node = worker_nodes[t % worker_nodes.size()];
+                    pin_current_thread(load.cpu);
+                }
+                {
+                    TraceScope setup(trace, t + 1, "worker setup");
+                    auto setup_start = chrono::steady_clock::now();
+                    workers[t].reset(new Graph(*this));
+                    workers[t]->reset_worker_state(t + 1);
+                    load.setup_ns = ns_since(setup_start);
+                }
+                Graph& w = *workers[t];
+                unique_ptr<PerfCounters> perf;
+                if (measure_thread_perf) {
+                    perf.reset(new PerfCounters());
+                    perf->start();
+                }
+                while (true) {
+                    if (control && control->stopped()) break;
+                    int first = next_root.fetch_add(root_grain);
+                    if (first >= num_roots) break;
+                    int last = min(first + root_grain, num_roots);
+                    long long claim_start = trace ? trace->now() : 0;
+                    auto busy_start = chrono::steady_clock::now();
+                    for (int j = first; j < last; j++) w.expand_root(order[ranks[j]], ranks[j], rank);
+                    load.busy_ns += ns_since(busy_start);
+                    load.claims++;
+                    load.roots += last - first;
+                    if (trace) trace->record(t + 1, "claim", claim_start, trace->now(), first, last - 1);
+                }
+                w.flush_ego();
+                if (perf) worker_perf[t] = perf->stop();
+            });
         }
+        for (auto& th : threads) th.join();
+        long long phase_ns = ns_since(phase_start);
+        if (measure_thread_perf) thread_perf = worker_perf;
+        for (int t = 0; t < num_threads; t++) {
+            loads[t].nodes = workers[t]->node_visits;
+            loads[t].idle_ns = max(0LL, phase_ns - loads[t].setup_ns - loads[t].busy_ns);
+        }
+        worker_load = loads;
+
+        for (const auto& w : workers) merge_worker(*w);
+        if (memory) memory->set(MemoryLedger::WORKERS, 0);
     }
 
-    void bron_kerbosch_degeneracy() {
+    // External mode: search the roots batch by batch on one thread, while an
+    // I/O thread reads the lists of the following batch
+    void run_external_roots(const vector<int>& order, const vector<int>& rank, const vector<int>& ranks) {
         rev_idx.clear();
         rev_idx.resize(num_vertices, -1);
-        for (int i = 0; i < num_vertices; i++) {
-            int v = dgn_order[i];
-            vector<int> P, X;
-            for (int u : adj_list[v]) {
-                if (rev_dgn[u] < i)
-                    X.push_back(u);
+        if (memory) memory->set(MemoryLedger::SEARCH_STATE, search_state_bytes());
+        batch_slot.assign(num_vertices, -1);
+        RowPrefetcher prefetch(*external, order, rank, ranks, external_batch_bytes);
+        prefetch.start();
+        unique_ptr<RowBatch> b;
+        while (!(control && control->stopped()) && prefetch.next(b)) {
+            long long trace_start = trace ? trace->now() : 0;
+            batch = b.get();
+            for (int j = 0; j < b->size(); j++) batch_slot[b->vertices[j]] = j;
+            for (int i : b->roots) {
+                if (control && control->stopped()) break;
+                expand_root(order[i], i, rank);
+            }
+            for (int u : b->vertices) batch_slot[u] = -1;
+            batch = nullptr;
+            if (trace) trace->record(trace_tid, "batch", trace_start, trace->now(), b->roots.front(), b->roots.back());
+            prefetch.recycle(move(b));
+        }
+        prefetch.stop();
+        flush_ego();
+        external_stats = prefetch.stats();
+        // The search holds one batch while the I/O thread fills up to two
+        if (memory) memory->touch(MemoryLedger::SEARCH_STATE, 3 * external_stats.peak_batch_bytes);
+    }
+
+    // Search the root v, the i-th vertex in the root order, on the plain
+    // adjacency or, in compressed and external mode, on its ego network
+    void expand_root(int v, int i, const vector<int>& rank) {
+        if (!packed && !external) {
+            search_root(v, i, rank);
+            return;
+        }
+        build_ego(v, rank);
+        ego->search_root(0, i, ego_rank);
+        if (profile_roots && !ego->root_profile.empty() && ego->root_profile.back().rank == i)
+            ego->root_profile.back().vertex = v;
+    }
+
+    // Local graph of v's closed neighborhood: v is vertex 0, followed by its
+    // neighbors before v in the root order (X), then those after v (P), and
+    // ego_rank gives them their positions in the root order, so the root
+    // subproblem is the same as on the full graph. The engine only ever looks
+    // at the neighbors in P of a list (its prefix within the current P), so
+    // only the lists of P are decoded, filtered to P, and the X lists are
+    // their X-P edges turned around.
+    void build_ego(int v, const vector<int>& rank) {
+        if (!ego) {
+            ego.reset(new Graph());
+            ego->control = control;
+            ego->count_hot_path = count_hot_path;
+            ego->collect_stats = collect_stats;
+            ego->profile_roots = profile_roots;
+            ego->pivot_from_p = pivot_from_p;
+            ego->trace = trace;
+            ego->trace_tid = trace_tid;
+            ego->clique_store = clique_store;
+            ego->clique_spool = clique_spool;
+            ego->clique_ids = &ego_vertex;
+            ego->clique_count = 0;
+            ego->node_visits = 0;
+        }
+        if ((int)ego_local.size() != num_vertices) ego_local.assign(num_vertices, 0);
+
+        // ego_local: local id of a neighbor, negated for X
+        decoded.clear();
+        for_each_neighbor(v, [&](int u) { decoded.push_back(u); });
+        int k = decoded.size();
+        int num_x = 0;
+        for (int u : decoded)
+            if (rank[u] < rank[v]) num_x++;
+        ego_vertex.resize(k + 1);
+        ego_rank.resize(k + 1);
+        ego_vertex[0] = v;
+        int next_x = 1, next_p = num_x + 1;
+        for (int u : decoded) {
+            bool in_x = rank[u] < rank[v];
+            int l = in_x ? next_x++ : next_p++;
+            ego_local[u] = in_x ? -l : l;
+            ego_vertex[l] = u;
+        }
+        for (int j = 0; j <= k; j++) ego_rank[j] = rank[ego_vertex[j]];
+
+        // Decode the P lists into ego_edges, one run per P vertex, counting
+        // list lengths in ego_degree
+        ego_degree.assign(k + 1, 0);
+        ego_run_end.resize(k + 1);
+        ego_degree[0] = k;
+        ego_edges.clear();
+        for (int j = num_x + 1; j <= k; j++) {
+            for_each_neighbor(ego_vertex[j], [&](int w) {
+                int l = ego_local[w];
+                if (l == 0) return;
+                ego_edges.push_back(l);
+                ego_degree[l > 0 ? j : -l]++;
+            });
+            ego_run_end[j] = ego_edges.size();
+        }
+        for (int j = 1; j <= k; j++) ego_local[ego_vertex[j]] = 0;
+
+        Adjacency& local = ego->adj_list;
+        local.offsets.resize(k + 2);
+        local.offsets[0] = 0;
+        for (int j = 0; j <= k; j++) local.offsets[j + 1] = local.offsets[j] + ego_degree[j];
+        local.targets.resize(local.offsets[k + 1]);
+        for (int j = 1; j <= k; j++) local.targets[j - 1] = j;
+        ego_cursor.assign(local.offsets.begin(), local.offsets.end() - 1);
+        size_t e = 0;
+        for (int j = num_x + 1; j <= k; j++) {
+            for (; e < ego_run_end[j]; e++) {
+                int l = ego_edges[e];
+                if (l > 0)
+                    local.targets[ego_cursor[j]++] = l;
                 else
-                    P.push_back(u);
+                    local.targets[ego_cursor[-l]++] = j;
             }
-            v_list.clear();
-            v_list.insert(v_list.end(), X.begin(), X.end());
-            v_list.insert(v_list.end(), P.begin(), P.end());
+        }
+        ego->num_vertices = k + 1;
+        ego->num_edges = local.targets.size() / 2;
+        ego->max_degree = k;
+    }
 
-            for (int j = 0; j < v_list.size(); j++) rev_idx[v_list[j]] = j;
+    // Move the ego graph's counters and profile into this graph
+    void flush_ego() {
+        if (!ego) return;
+        merge_worker(*ego);
+        ego->reset_worker_state(trace_tid);
+    }
 
-            for (int u : v_list) {
-                auto& neighbors = adj_list[u];
-                int write = 0;
+    // Clear the per-run results of a freshly copied worker
+    void reset_worker_state(int tid) {
+        clique_count = 0;
+        node_visits = 0;
+        hot_path = HotPathCounters();
+        stats = SearchStats();
+        root_profile.clear();
+        trace_tid = tid;
+        clique_spool = clique_store ? clique_store->spool(tid) : nullptr;
+        rev_idx.clear();
+        rev_idx.resize(num_vertices, -1);
+        ego.reset();
+    }
 
-                for (int read = 0; read < (int)neighbors.size(); ++read) {
-                    int w = neighbors[read];
-                    if (rev_idx[w] >= X.size() && rev_idx[w] < v_list.size()) {
-                        std::swap(neighbors[write], neighbors[read]);
-                        ++write;
-                    }
-                }
+    void merge_worker(const Graph& w) {
+        clique_count += w.clique_count;
+        node_visits += w.node_visits;
+        hot_path.merge(w.hot_path);
+        stats.merge(w.stats);
+        root_profile.insert(root_profile.end(), w.root_profile.begin(), w.root_profile.end());
+    }
+
+    // Basic Bron-Kerbosch without degeneracy ordering
+    void bron_kerbosch_basic(int num_threads = 1) {
+        // Start with R = {}, P = all vertices, X = {}
+        // We iterate over all vertices (similar to degeneracy but in natural order):
+        // X = neighbors with index < i, P = neighbors with index > i
+        vector<int> natural_order(num_vertices);
+        for (int i = 0; i < num_vertices; i++) natural_order[i] = i;
+
+        run_roots(natural_order, natural_order, num_threads);
+    }
+
+    void bron_kerbosch_degeneracy(int num_threads = 1) {
+        run_roots(dgn_order, rev_dgn, num_threads);
+    }
+
+    // Follow one random path from the root subproblem of v down to a leaf
+    // (Knuth's estimator), weighting each node by the product of the
+    // branching factors above it. The pivot probe picks among the candidates
+    // the engine explores, the tracked probe among all of P, as the tracked
+    // export also expands pivot-pruned candidates. Descends without restoring
+    // adjacency lists; prepare_root() lays them out afresh for every root.
+    void probe_root(int v, int i, const vector<int>& rank, bool tracked, double weight, mt19937_64& rng, ProbeResult& out) {
+        int x_idx = 0;
+        int p_idx = prepare_root(v, i, rank);
+        int e_idx = v_list.size();
+        int r_size = 1;
+        bool pruned_path = false;
+        vector<int> r_candidates, pruned_candidates;
+
+        while (true) {
+            out.nodes += weight;
+            out.work += weight * (1 + e_idx - x_idx);
+            out.set_entries += weight * (r_size + e_idx - x_idx);
+            if (x_idx == p_idx && p_idx == e_idx) {
+                if (!pruned_path) out.cliques += weight;
+                break;
+            }
+            if (p_idx == e_idx) break;
+
+            int pivot = select_pivot<false>(x_idx, p_idx, e_idx);
+            vector<bool> pivot_neigh(e_idx - p_idx);
+            mark_pivot_neighbors(pivot, p_idx, e_idx, pivot_neigh);
+            r_candidates.clear();
+            pruned_candidates.clear();
+            for (int j = p_idx; j < e_idx; j++) (pivot_neigh[j - p_idx] ? pruned_candidates : r_candidates).push_back(v_list[j]);
+
+            int branching = tracked ? e_idx - p_idx : r_candidates.size();
+            out.children += weight * branching;
+            if (branching == 0) break;
+            int k = uniform_int_distribution<int>(0, branching - 1)(rng);
+
+            // The engine has moved the earlier explored candidates from P to
+            // X by the time it expands the k-th one, and all of them before
+            // it expands a pivot-pruned one
+            int explored_before = min(k, (int)r_candidates.size());
+            for (int j = 0; j < explored_before; j++) {
+                int c = r_candidates[j];
+                int num_x = partition_x<false>(c, x_idx, p_idx, e_idx);
+                int num_p = partition_p<false>(c, p_idx, e_idx);
+                restore_after_child<false>(c, p_idx, e_idx, num_x, num_p);
+                rev_idx[v_list[p_idx]] = rev_idx[c];
+                rev_idx[c] = p_idx;
+                swap(v_list[p_idx], v_list[rev_idx[v_list[p_idx]]]);
+                p_idx++;
             }
+            int cand;
+            if (k < (int)r_candidates.size()) {
+                cand = r_candidates[k];
+            } else {
+                cand = pruned_candidates[k - r_candidates.size()];
+                pruned_path = true;
+            }
+
+            int num_x = partition_x<false>(cand, x_idx, p_idx, e_idx);
+            int num_p = partition_p<false>(cand, p_idx, e_idx);
+            reorder_for_child<false>(p_idx, e_idx, num_x, num_p);
+            x_idx = p_idx - num_x;
+            e_idx = p_idx + num_p;
+            weight *= branching;
+            r_size++;
+        }
+        finish_root();
+    }
 
-            clique.push_back(v);
-            bron_kerbosch_pivot(0, X.size(), v_list.size());
+    // Estimate the size and cost of the run over the given root order within
+    // about budget_ms. A quarter of the budget calibrates ns per unit of work
+    // on complete searches of random cheap roots; the rest alternates pivot
+    // and tracked probes over the roots in a random order.
+    SearchEstimate estimate_search(const vector<int>& order, const vector<int>& rank, double budget_ms, unsigned long long seed = 1) {
+        SearchEstimate est;
+        est.num_vertices = num_vertices;
+        auto start = chrono::steady_clock::now();
+        auto elapsed_ms = [&]() { return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(); };
+        if (num_vertices == 0) return est;
+        if ((int)rev_idx.size() != num_vertices) rev_idx.assign(num_vertices, -1);
+
+        mt19937_64 rng(seed);
+        vector<int> roots(num_vertices);
+        for (int j = 0; j < num_vertices; j++) roots[j] = j;
+        shuffle(roots.begin(), roots.end(), rng);
+
+        // Calibration runs the stats instantiation to measure work exactly;
+        // roots whose single probe predicts much work are skipped
+        bool saved_collect_stats = collect_stats;
+        SearchStats saved_stats = stats;
+        long long saved_clique_count = clique_count;
+        long long saved_node_visits = node_visits;
+        double calibration_ns = 0, calibration_work = 0;
+        collect_stats = true;
+        for (int j = 0; j < num_vertices && elapsed_ms() < budget_ms / 4; j++) {
+            int i = roots[j];
+            ProbeResult guess;
+            probe_root(order[i], i, rank, false, 1, rng, guess);
+            if (guess.work > 1e5) continue;
+            stats = SearchStats();
+            long long nodes_before = node_visits;
+            auto root_start = chrono::steady_clock::now();
+            int x_size = prepare_root(order[i], i, rank);
+            clique.push_back(order[i]);
+            bron_kerbosch_pivot(0, x_size, v_list.size());
             clique.pop_back();
+            finish_root();
+            calibration_ns += chrono::duration<double, nano>(chrono::steady_clock::now() - root_start).count();
+            calibration_work += (node_visits - nodes_before) + stats.p_size_sum + stats.x_size_sum;
+            est.calibration_roots++;
+        }
+        collect_stats = saved_collect_stats;
+        stats = saved_stats;
+        clique_count = saved_clique_count;
+        node_visits = saved_node_visits;
+        if (calibration_work > 0) est.ns_per_work = calibration_ns / calibration_work;
+
+        for (long long j = 0; elapsed_ms() < budget_ms; j++) {
+            int i = roots[j % num_vertices];
+            ProbeResult pivot_probe, tracked_probe;
+            probe_root(order[i], i, rank, false, num_vertices, rng, pivot_probe);
+            probe_root(order[i], i, rank, true, num_vertices, rng, tracked_probe);
+            est.nodes.add(pivot_probe.nodes);
+            est.cliques.add(pivot_probe.cliques);
+            est.work.add(pivot_probe.work);
+            est.tracked.push_back(tracked_probe);
+        }
+        est.elapsed_ms = elapsed_ms();
+        return est;
+    }
+
+    SearchEstimate estimate_basic(double budget_ms) {
+        vector<int> natural_order(num_vertices);
+        for (int i = 0; i < num_vertices; i++) natural_order[i] = i;
+        return estimate_search(natural_order, natural_order, budget_ms);
+    }
+
+    SearchEstimate estimate_degeneracy(double budget_ms) { return estimate_search(dgn_order, rev_dgn, budget_ms); }
 
-            for (int j = 0; j < v_list.size(); j++) {
-                rev_idx[v_list[j]] = -1;
+    // Record root subproblems into a timeline trace
+    void set_trace(TraceWriter* writer) {
+        trace = writer;
+        trace_tid = 0;
+    }
+
+    void set_root_grain(int grain) { root_grain = max(1, grain); }
+
+    void set_pivot_from_p(bool from_p) { pivot_from_p = from_p; }
+
+    // Pin parallel worker t to cpus[t] on NUMA node nodes[t]
+    void set_worker_placement(const vector<int>& cpus, const vector<int>& nodes) {
+        worker_cpus = cpus;
+        worker_nodes = nodes;
+    }
+
+    // Cost estimate of every root by rank for progress ETAs: laying out its
+    // neighborhood (the neighbors' degrees) plus |P|^2 times its degree for
+    // the subtree. Fitted against --root-profile timings of web-Google,
+    // Epinions and twitch; no simple model tracks all of them closely.
+    vector<long long> estimated_root_costs(bool degeneracy) const {
+        vector<long long> costs(num_vertices);
+        for_each_list([&](int v, Span<const int> neighbors) {
+            int i = degeneracy ? rev_dgn[v] : v;
+            long long later = 0, layout = 0;
+            for (int u : neighbors) {
+                if ((degeneracy ? rev_dgn[u] : u) > i) later++;
+                layout += degrees[u];
             }
-        }
+            costs[i] = 1 + layout + later * later * (long long)degrees[v];
+        });
+        return costs;
+    }
+
+    // Skip roots the control marks done and stop when it says so
+    void set_run_control(RunControl* c) { control = c; }
+
+    // Identifies the graph in checkpoints: n, m and an order-independent
+    // hash of the edge set
+    string fingerprint() const {
+        unsigned long long h = 0;
+        for_each_list([&](int u, Span<const int> neighbors) {
+            for (int w : neighbors) {
+                unsigned long long x = (unsigned long long)u * num_vertices + w + 0x9e3779b97f4a7c15ULL;
+                x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+                h += x ^ (x >> 31);
+            }
+        });
+        ostringstream out;
+        out << num_vertices << ' ' << num_edges << ' ' << hex << h;
+        return out.str();
     }
 
+    // Measure hardware counters per parallel worker (see perf_counters.h)
+    void enable_thread_perf() { measure_thread_perf = true; }
+
+    const vector<PerfSample>& thread_perf_samples() const { return thread_perf; }
+
+    // Per-worker setup, busy and idle time of the last parallel run (empty
+    // after a sequential one)
+    const vector<WorkerLoad>& worker_loads() const { return worker_load; }
+
     // Enable search tree tracking
     void enable_search_tree_tracking() {
         track_search_tree = true;
         node_counter = 0;
         search_tree_nodes.clear();
+        tracking_heap_bytes = 0;
+        tracking_spilled = false;
+        spilled = SpilledTreeTotals();
+    }
+
+    // Account memory in the given ledger (see memory.h)
+    void set_memory_ledger(MemoryLedger* ledger) { memory = ledger; }
+
+    // Spill finished search tree nodes to spill_file once tracking holds
+    // more than budget bytes
+    void set_tracking_budget(long long budget, const string& spill_file) {
+        tracking_budget = budget;
+        spill_path = spill_file;
+    }
+
+    bool tracking_spills() const { return tracking_spilled; }
+
+    static long long node_heap_bytes(const SearchTreeNode& node) {
+        return sizeof(int) *
+               (node.children_ids.size() + node.current_clique.size() + node.p_set.size() + node.x_set.size());
+    }
+
+    long long tracking_bytes() const {
+        return sizeof(SearchTreeNode) * search_tree_nodes.capacity() + tracking_heap_bytes + snapshot_bytes;
+    }
+
+    // Tracked node by id; once spilling, the nodes in memory are the current
+    // path, ascending by id
+    SearchTreeNode& tracked_node(int id) {
+        if (!tracking_spilled) return search_tree_nodes[id];
+        auto it = lower_bound(search_tree_nodes.begin(), search_tree_nodes.end(), id,
+                              [](const SearchTreeNode& node, int key) { return node.node_id < key; });
+        return *it;
+    }
+
+    void update_tracking_memory() {
+        long long bytes = tracking_bytes();
+        if (memory) memory->set(MemoryLedger::TRACKING, bytes);
+        if (tracking_budget > 0 && !tracking_spilled && bytes > tracking_budget) start_tracking_spill();
+    }
+
+    // Write the finished nodes out and keep only the unfinished ones, which
+    // are the path to the node being created
+    void start_tracking_spill() {
+        spill_out.reset(new AsyncOutput(spill_path));
+        if (!spill_out->is_open()) {
+            cerr << "Error: Could not open file " << spill_path << " for writing, keeping the search tree in memory"
+                 << endl;
+            tracking_budget = 0;
+            return;
+        }
+        cout << "Search tree exceeds its memory budget of " << MemoryLedger::format_bytes(tracking_budget)
+             << ", spilling finished nodes to " << spill_path << "\n";
+        tracking_spilled = true;
+        if (memory) memory->add(MemoryLedger::OUTPUT, spill_out->bytes());
+        vector<SearchTreeNode> path;
+        tracking_heap_bytes = 0;
+        for (auto& node : search_tree_nodes) {
+            if (node.subtree_complete) {
+                spill_tracked_node(node);
+            } else {
+                tracking_heap_bytes += node_heap_bytes(node);
+                path.push_back(move(node));
+            }
+        }
+        search_tree_nodes.swap(path);
+        if (memory) memory->set(MemoryLedger::TRACKING, tracking_bytes());
+    }
+
+    void spill_tracked_node(const SearchTreeNode& node) {
+        write_tree_row(*spill_out, node, false);
+        spilled.nodes++;
+        if (node.pruned_by_pivot) spilled.pruned++;
+        if (node.children_ids.empty()) spilled.leaves++;
+        spilled.max_depth = max(spilled.max_depth, node.depth);
+        if (node.parent_id == -1) {
+            spilled.roots.push_back(node.node_id);
+            spilled.root_cliques += node.cliques_in_subtree;
+        }
+    }
+
+    // Called when the last tracked node has finished its subtree
+    void finish_tracked_node() {
+        if (!tracking_spilled) return;
+        spill_tracked_node(search_tree_nodes.back());
+        tracking_heap_bytes -= node_heap_bytes(search_tree_nodes.back());
+        search_tree_nodes.pop_back();
     }
 
     // Disable search tree tracking
@@ -472,9 +1457,124 @@ public:
         track_search_tree = false;
     }
 
-    // Export search tree to CSV
-    void export_search_tree_to_csv(const string& filename) {
-        ofstream csv_file(filename);
+    // Enable hot-path counters; selects the counting instantiation of the engine
+    void enable_hot_path_counters() {
+        count_hot_path = true;
+        hot_path = HotPathCounters();
+    }
+
+    const HotPathCounters& hot_path_counters() const { return hot_path; }
+
+    // Collect search tree shape statistics without tracking individual nodes
+    void enable_search_stats() {
+        collect_stats = true;
+        stats = SearchStats();
+    }
+
+    const SearchStats& search_stats() const { return stats; }
+
+    // Write every maximal clique found to the store's spool of each thread
+    void set_clique_store(const shared_ptr<CliqueStore>& store) {
+        clique_store = store;
+        clique_spool = store ? store->spool(trace_tid) : nullptr;
+    }
+
+    // Record per-root cost (order rank, |P|, |X|, nodes, cliques, time)
+    void enable_root_profile() {
+        profile_roots = true;
+        root_profile.clear();
+    }
+
+    // Export the per-root cost profile to CSV, one row per root in order rank
+    void export_root_profile_to_csv(const string& filename) {
+        AsyncOutput csv_file(filename);
+        if (!csv_file.is_open()) {
+            cerr << "Error: Could not open file " << filename << " for writing." << endl;
+            return;
+        }
+
+        vector<RootProfile> rows(root_profile);
+        sort(rows.begin(), rows.end(), [](const RootProfile& a, const RootProfile& b) { return a.rank < b.rank; });
+
+        csv_file << "rank,vertex,p_size,x_size,nodes,cliques,ns\n";
+        long long total_ns = 0;
+        for (const auto& rp : rows) {
+            csv_file << rp.rank << ',' << rp.vertex << ',' << rp.p_size << ',' << rp.x_size << ','
+                     << rp.nodes << ',' << rp.cliques << ',' << rp.ns << '\n';
+            total_ns += rp.ns;
+        }
+        if (!csv_file.close()) {
+            cerr << "Error: Could not write " << filename << endl;
+            return;
+        }
+
+        // Share of the time spent in the most expensive 1% of roots
+        vector<long long> ns;
+        for (const auto& rp : rows) ns.push_back(rp.ns);
+        sort(ns.rbegin(), ns.rend());
+        size_t top = max<size_t>(1, ns.size() / 100);
+        long long top_ns = 0;
+        for (size_t i = 0; i < top && i < ns.size(); i++) top_ns += ns[i];
+
+        cout << "Root profile exported to " << filename << " (" << rows.size() << " roots";
+        if (total_ns > 0) cout << ", top 1% of roots take " << (top_ns * 100.0 / total_ns) << "% of root time";
+        cout << ")" << endl;
+        cout << "  Output: " << csv_file.stats().summary() << endl;
+    }
+
+    // One CSV row of the search tree export; the partial column is appended
+    // by the caller when needed
+    static void write_tree_row(ostream& csv_file, const SearchTreeNode& node, bool partial) {
+        csv_file << node.node_id << ",";
+        csv_file << node.parent_id << ",";
+
+        // Children IDs (semicolon-separated)
+        csv_file << "\"";
+        for (size_t i = 0; i < node.children_ids.size(); i++) {
+            if (i > 0) csv_file << ";";
+            csv_file << node.children_ids[i];
+        }
+        csv_file << "\",";
+
+        csv_file << node.cliques_in_subtree << ",";
+        csv_file << node.creation_order << ",";
+        csv_file << node.depth << ",";
+        csv_file << node.candidate_vertex << ",";
+
+        // Current clique (semicolon-separated)
+        csv_file << "\"";
+        for (size_t i = 0; i < node.current_clique.size(); i++) {
+            if (i > 0) csv_file << ";";
+            csv_file << node.current_clique[i];
+        }
+        csv_file << "\",";
+
+        // X set (semicolon-separated)
+        csv_file << "\"";
+        for (size_t i = 0; i < node.x_set.size(); i++) {
+            if (i > 0) csv_file << ";";
+            csv_file << node.x_set[i];
+        }
+        csv_file << "\",";
+
+        // P set (semicolon-separated)
+        csv_file << "\"";
+        for (size_t i = 0; i < node.p_set.size(); i++) {
+            if (i > 0) csv_file << ";";
+            csv_file << node.p_set[i];
+        }
+        csv_file << "\",";
+
+        csv_file << (node.pruned_by_pivot ? "true" : "false");
+        if (partial) csv_file << (node.subtree_complete ? ",false" : ",true");
+        csv_file << "\n";
+    }
+
+    // Export search tree to CSV. A partial export (the run was stopped) adds
+    // a trailing partial column, true for nodes whose subtree was not finished.
+    // Spilled nodes come first, in the order they finished.
+    void export_search_tree_to_csv(const string& filename, bool partial = false) {
+        AsyncOutput csv_file(filename);
         if (!csv_file.is_open()) {
             cerr << "Error: Could not open file " << filename << " for writing." << endl;
             return;
@@ -482,15 +1582,17 @@ public:
 
         // Write CSV header
         csv_file << "node_id,parent_id,children_ids,cliques_in_subtree,creation_order,depth,"
-                 << "candidate_vertex,current_clique,x_set,p_set,pruned_by_pivot" << endl;
+                 << "candidate_vertex,current_clique,x_set,p_set,pruned_by_pivot" << (partial ? ",partial" : "") << endl;
 
-        // Find all root nodes (parent_id == -1) and calculate total cliques
-        vector<int> root_nodes;
-        int total_root_cliques = 0;
+        // Find all root nodes (parent_id == -1) and calculate total cliques.
+        // The cliques of a root cut short are not in the reported count, so
+        // they are left out here too
+        vector<int> root_nodes(spilled.roots);
+        long long total_root_cliques = spilled.root_cliques;
         for (const auto& node : search_tree_nodes) {
             if (node.parent_id == -1) {
                 root_nodes.push_back(node.node_id);
-                total_root_cliques += node.cliques_in_subtree;
+                if (!partial || node.subtree_complete) total_root_cliques += node.cliques_in_subtree;
             }
         }
 
@@ -500,75 +1602,49 @@ public:
             if (i > 0) csv_file << ";";
             csv_file << root_nodes[i];
         }
-        csv_file << "\"," << total_root_cliques << ",-1,-1,-1,\"\",\"\",\"\",false" << endl;
+        csv_file << "\"," << total_root_cliques << ",-1,-1,-1,\"\",\"\",\"\",false" << (partial ? ",true" : "") << endl;
+
+        // Spilled nodes are all finished
+        if (tracking_spilled) {
+            if (memory) memory->add(MemoryLedger::OUTPUT, -spill_out->bytes());
+            if (!spill_out->close()) cerr << "Error: Could not write " << spill_path << ", the exported tree is incomplete" << endl;
+            ifstream spill_in(spill_path);
+            string line;
+            while (getline(spill_in, line)) csv_file << line << (partial ? ",false\n" : "\n");
+            spill_in.close();
+            remove(spill_path.c_str());
+        }
 
         // Write each actual node
-        for (const auto& node : search_tree_nodes) {
-            csv_file << node.node_id << ",";
-            csv_file << node.parent_id << ",";
-
-            // Children IDs (semicolon-separated)
-            csv_file << "\"";
-            for (size_t i = 0; i < node.children_ids.size(); i++) {
-                if (i > 0) csv_file << ";";
-                csv_file << node.children_ids[i];
-            }
-            csv_file << "\",";
+        for (const auto& node : search_tree_nodes) write_tree_row(csv_file, node, partial);
 
-            csv_file << node.cliques_in_subtree << ",";
-            csv_file << node.creation_order << ",";
-            csv_file << node.depth << ",";
-            csv_file << node.candidate_vertex << ",";
-
-            // Current clique (semicolon-separated)
-            csv_file << "\"";
-            for (size_t i = 0; i < node.current_clique.size(); i++) {
-                if (i > 0) csv_file << ";";
-                csv_file << node.current_clique[i];
-            }
-            csv_file << "\",";
-
-            // X set (semicolon-separated)
-            csv_file << "\"";
-            for (size_t i = 0; i < node.x_set.size(); i++) {
-                if (i > 0) csv_file << ";";
-                csv_file << node.x_set[i];
-            }
-            csv_file << "\",";
-
-            // P set (semicolon-separated)
-            csv_file << "\"";
-            for (size_t i = 0; i < node.p_set.size(); i++) {
-                if (i > 0) csv_file << ";";
-                csv_file << node.p_set[i];
-            }
-            csv_file << "\",";
-
-            csv_file << (node.pruned_by_pivot ? "true" : "false") << endl;
+        if (!csv_file.close()) {
+            cerr << "Error: Could not write " << filename << endl;
+            return;
         }
-
-        csv_file.close();
-        cout << "Search tree exported to " << filename << " (" << (search_tree_nodes.size() + 1) << " nodes including virtual root)" << endl;
+        cout << (partial ? "Partial search tree" : "Search tree") << " exported to " << filename << " ("
+             << (spilled.nodes + search_tree_nodes.size() + 1) << " nodes including virtual root)" << endl;
+        cout << "  Output: " << csv_file.stats().summary() << endl;
+        if (tracking_spilled) cout << "  Spill output: " << spill_out->stats().summary() << endl;
     }
 
     // Get statistics about the search tree
     void print_search_tree_stats() {
-        if (search_tree_nodes.empty()) {
+        long long total_nodes = spilled.nodes + search_tree_nodes.size();
+        if (total_nodes == 0) {
             cout << "No search tree data available." << endl;
             return;
         }
 
-        int max_depth = 0;
-        int total_cliques = 0;
-        int leaf_nodes = 0;
-        int pruned_nodes = 0;
-        int explored_nodes = 0;
+        int max_depth = spilled.max_depth;
+        long long leaf_nodes = spilled.leaves;
+        long long pruned_nodes = spilled.pruned;
+        long long explored_nodes = spilled.nodes - spilled.pruned;
 
         for (const auto& node : search_tree_nodes) {
             max_depth = max(max_depth, node.depth);
             if (node.children_ids.empty()) {
                 leaf_nodes++;
-                total_cliques += node.cliques_in_subtree;
             }
             if (node.pruned_by_pivot) {
                 pruned_nodes++;
@@ -578,12 +1654,14 @@ public:
         }
 
         cout << "Search Tree Statistics:" << endl;
-        cout << "  Total nodes: " << search_tree_nodes.size() << endl;
+        cout << "  Total nodes: " << total_nodes << endl;
         cout << "  Explored nodes (with pivot): " << explored_nodes << endl;
         cout << "  Pruned nodes (by pivot): " << pruned_nodes << endl;
-        cout << "  Pruning ratio: " << (pruned_nodes * 100.0 / search_tree_nodes.size()) << "%" << endl;
+        cout << "  Pruning ratio: " << (pruned_nodes * 100.0 / total_nodes) << "%" << endl;
         cout << "  Leaf nodes: " << leaf_nodes << endl;
         cout << "  Max depth: " << max_depth << endl;
         cout << "  Total cliques found: " << clique_count << endl;
     }
 };
+
+#endif
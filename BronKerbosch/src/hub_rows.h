@@ -0,0 +1,131 @@
+#ifndef HUB_ROWS_H
+#define HUB_ROWS_H
+
+#include <bits/stdc++.h>
+
+#include "adjacency.h"
+
+using namespace std;
+
+// Neighbor sets of the highest-degree vertices (hubs) as Roaring-style
+// bitmaps: the ids are split into chunks of 2^16 by their high 16 bits, and
+// a hub's neighbors in a chunk are a sorted array of their low 16 bits, or a
+// 2^16-bit bitmap once there are more than kArrayMax of them. Roaring
+// switches at 4096, where the bitmap's 8 KB becomes the smaller of the two;
+// here the point is lookup speed, and binary searches over long arrays
+// cost the engine more than the lists they replace, so arrays stay short.
+// Every hub has a slot in a table of its chunks, so a membership test is
+// one lookup plus a bit test or a short binary search, whatever the hub's
+// degree.
+//
+// The engine answers "is w a neighbor of hub h" from here instead of
+// scanning h's list, and no longer keeps hub lists ordered with their
+// neighbors in P first (see the kernels in graph.h), which for a hub means
+// rewriting a list of hundreds or thousands of entries at every root and
+// every search tree node it belongs to.
+class HubRows {
+public:
+    // Lists shorter than this are scanned faster than looked up
+    static const int kMinDegree = 64;
+
+private:
+    static const int kChunkBits = 16;
+    static const int kArrayMax = 64;
+    static const unsigned kNone = UINT_MAX;
+
+    struct Container {
+        unsigned begin;  // into values, or into words for a bitmap
+        unsigned size;  // number of values; 0 for a bitmap
+    };
+
+    int num_chunks = 0;
+    int min_degree = 0;
+    vector<int> slot_of;  // vertex -> hub slot, or -1
+    vector<int> hubs;  // slot -> vertex
+    vector<unsigned> chunk_container;  // slot * num_chunks + chunk -> container, or kNone
+    vector<Container> containers;
+    vector<unsigned short> values;
+    vector<unsigned long long> words;
+    long long bitmap_containers = 0;
+
+public:
+    // The vertices of degree at least min_degree, in the given adjacency
+    void build(const Adjacency& adj, int min_degree) {
+        *this = HubRows();
+        int n = adj.size();
+        this->min_degree = min_degree;
+        num_chunks = (n >> kChunkBits) + 1;
+        slot_of.assign(n, -1);
+        for (int u = 0; u < n; u++)
+            if ((int)adj[u].size() >= min_degree && !adj[u].empty()) {
+                slot_of[u] = hubs.size();
+                hubs.push_back(u);
+            }
+        chunk_container.assign((size_t)hubs.size() * num_chunks, unsigned(kNone));
+
+        vector<int> sorted;
+        for (size_t slot = 0; slot < hubs.size(); slot++) {
+            auto neighbors = adj[hubs[slot]];
+            sorted.assign(neighbors.begin(), neighbors.end());
+            sort(sorted.begin(), sorted.end());
+            for (size_t first = 0; first < sorted.size();) {
+                int chunk = sorted[first] >> kChunkBits;
+                size_t last = first;
+                while (last < sorted.size() && (sorted[last] >> kChunkBits) == chunk) last++;
+                Container c;
+                if (last - first > (size_t)kArrayMax) {
+                    c.begin = words.size();
+                    c.size = 0;
+                    words.resize(words.size() + (1 << kChunkBits) / 64, 0);
+                    for (size_t j = first; j < last; j++) {
+                        unsigned low = sorted[j] & 0xffff;
+                        words[c.begin + low / 64] |= 1ULL << (low % 64);
+                    }
+                    bitmap_containers++;
+                } else {
+                    c.begin = values.size();
+                    c.size = last - first;
+                    for (size_t j = first; j < last; j++) values.push_back(sorted[j] & 0xffff);
+                }
+                chunk_container[slot * num_chunks + chunk] = containers.size();
+                containers.push_back(c);
+                first = last;
+            }
+        }
+    }
+
+    bool empty() const { return hubs.empty(); }
+    int num_hubs() const { return hubs.size(); }
+    int threshold() const { return min_degree; }
+    long long num_containers() const { return containers.size(); }
+    long long num_bitmap_containers() const { return bitmap_containers; }
+
+    // Hub slot of u, or -1 if u is not a hub
+    int slot(int u) const { return slot_of[u]; }
+
+    bool contains(int slot, int w) const {
+        unsigned index = chunk_container[(size_t)slot * num_chunks + (w >> kChunkBits)];
+        if (index == kNone) return false;
+        const Container& c = containers[index];
+        unsigned low = w & 0xffff;
+        if (c.size == 0) return (words[c.begin + low / 64] >> (low % 64)) & 1;
+        const unsigned short* first = values.data() + c.begin;
+        return binary_search(first, first + c.size, (unsigned short)low);
+    }
+
+    long long bytes() const {
+        return sizeof(int) * (slot_of.capacity() + hubs.capacity()) + sizeof(unsigned) * chunk_container.capacity() +
+               sizeof(Container) * containers.capacity() + sizeof(unsigned short) * values.capacity() +
+               sizeof(unsigned long long) * words.capacity();
+    }
+
+    // Smallest degree among the k highest, so that about k vertices are hubs
+    static int degree_of_top(vector<int> degrees, int k) {
+        if (k <= 0 || degrees.empty()) return INT_MAX;
+        k = min(k, (int)degrees.size());
+        nth_element(degrees.begin(), degrees.begin() + (k - 1), degrees.end(), greater<int>());
+        return max(degrees[k - 1], 1);
+    }
+};
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef HUGE_PAGES_H
+#define HUGE_PAGES_H
+
+#include <bits/stdc++.h>
+
+#include <sys/mman.h>
+
+#include "memory.h"
+
+using namespace std;
+
+// Allocation of the large arrays the search reads at random (the flat
+// adjacency, rev_idx) on 2 MB pages. Blocks of at least one huge page are
+// mapped 2 MB aligned and advised with MADV_HUGEPAGE, so transparent huge
+// pages can back them; in hugetlb mode pages reserved in the kernel's
+// hugetlb pool (vm.nr_hugepages) are tried first. Smaller blocks, and every
+// block when a mapping fails, fall back to what the program would otherwise
+// get: the heap, or plain 4 KB pages.
+class HugePages {
+public:
+    enum Mode { OFF, THP, HUGETLB };
+    static const size_t kPageSize = 2 << 20;
+
+private:
+    enum Kind { PLAIN, ADVISED, HUGETLB_POOL };
+    struct State {
+        Mode mode = THP;
+        mutex m;
+        map<void*, pair<size_t, Kind>> blocks;  // mapped blocks by address
+        long long mapped = 0, advised = 0, hugetlb = 0;
+    };
+
+    static State& state() {
+        static State s;
+        return s;
+    }
+
+    static size_t round_up(size_t bytes) { return (bytes + kPageSize - 1) / kPageSize * kPageSize; }
+
+    static void* map_aligned(size_t len, Kind& kind) {
+        State& s = state();
+#ifdef MAP_HUGETLB
+        if (s.mode == HUGETLB) {
+            void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                kind = HUGETLB_POOL;
+                return p;
+            }
+        }
+#endif
+        // Over-map by a page and trim, for a 2 MB aligned start
+        char* raw = (char*)mmap(nullptr, len + kPageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == (char*)MAP_FAILED) return nullptr;
+        char* start = (char*)(((uintptr_t)raw + kPageSize - 1) / kPageSize * kPageSize);
+        if (start > raw) munmap(raw, start - raw);
+        if (raw + kPageSize > start) munmap(start + len, raw + kPageSize - start);
+        kind = PLAIN;
+#ifdef MADV_HUGEPAGE
+        if (s.mode != OFF && madvise(start, len, MADV_HUGEPAGE) == 0) kind = ADVISED;
+#endif
+        return start;
+    }
+
+public:
+    static void set_mode(Mode mode) { state().mode = mode; }
+    static Mode mode() { return state().mode; }
+
+    static const char* mode_name(Mode mode) { return mode == OFF ? "off" : mode == THP ? "thp" : "hugetlb"; }
+
+    static void* allocate(size_t bytes) {
+        if (bytes < kPageSize) return ::operator new(bytes);
+        size_t len = round_up(bytes);
+        Kind kind;
+        void* p = map_aligned(len, kind);
+        if (!p) return ::operator new(bytes);
+        State& s = state();
+        lock_guard<mutex> lock(s.m);
+        s.blocks[p] = make_pair(len, kind);
+        s.mapped += len;
+        if (kind == ADVISED) s.advised += len;
+        if (kind == HUGETLB_POOL) s.hugetlb += len;
+        return p;
+    }
+
+    static void deallocate(void* p, size_t bytes) {
+        if (bytes >= kPageSize) {
+            State& s = state();
+            unique_lock<mutex> lock(s.m);
+            auto it = s.blocks.find(p);
+            if (it != s.blocks.end()) {
+                size_t len = it->second.first;
+                Kind kind = it->second.second;
+                s.mapped -= len;
+                if (kind == ADVISED) s.advised -= len;
+                if (kind == HUGETLB_POOL) s.hugetlb -= len;
+                s.blocks.erase(it);
+                lock.unlock();
+                munmap(p, len);
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+    // Where the currently mapped blocks ended up; AnonHugePages counts the
+    // whole process, as the kernel does not report it per mapping
+    static void print_report(ostream& out) {
+        State& s = state();
+        long long mapped, advised, hugetlb;
+        {
+            lock_guard<mutex> lock(s.m);
+            mapped = s.mapped;
+            advised = s.advised;
+            hugetlb = s.hugetlb;
+        }
+        long long thp_kb = -1;
+        ifstream in("/proc/self/smaps_rollup");
+        string line;
+        while (getline(in, line))
+            if (line.compare(0, 14, "AnonHugePages:") == 0) thp_kb = atoll(line.c_str() + 14);
+        string thp_setting;
+        ifstream sys("/sys/kernel/mm/transparent_hugepage/enabled");
+        getline(sys, thp_setting);
+
+        out << "Huge pages (" << mode_name(s.mode) << "):\n";
+        out << "  2 MB aligned arrays: " << MemoryLedger::format_bytes(mapped) << ", advised for THP "
+            << MemoryLedger::format_bytes(advised) << ", from the hugetlb pool " << MemoryLedger::format_bytes(hugetlb)
+            << "\n";
+        out << "  Backed by transparent huge pages (whole process): "
+            << (thp_kb >= 0 ? MemoryLedger::format_bytes(thp_kb * 1024) : string("n/a"));
+        if (!thp_setting.empty()) out << ", THP setting " << thp_setting;
+        out << "\n";
+    }
+};
+
+template <class T>
+struct HugePageAllocator {
+    typedef T value_type;
+
+    HugePageAllocator() {}
+    template <class U>
+    HugePageAllocator(const HugePageAllocator<U>&) {}
+
+    T* allocate(size_t n) { return (T*)HugePages::allocate(n * sizeof(T)); }
+    void deallocate(T* p, size_t n) { HugePages::deallocate(p, n * sizeof(T)); }
+
+    template <class U>
+    bool operator==(const HugePageAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const HugePageAllocator<U>&) const { return false; }
+};
+
+template <class T>
+using HugeVector = vector<T, HugePageAllocator<T>>;
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Hot-path counters for bron_kerbosch_pivot. The engine is instantiated with
+// counting enabled only when profiling is requested, so the default
+// instantiation carries no counter updates at all.
+struct HotPathCounters {
+    long long pivot_scans = 0;    // adjacency entries read while scoring pivots
+    long long x_scans = 0;        // adjacency entries read while partitioning X
+    long long p_scans = 0;        // adjacency entries read while partitioning P
+    long long reorder_steps = 0;  // adjacency entries read while reordering for a child
+    long long restore_steps = 0;  // adjacency entries read while restoring after a child
+    vector<long long> calls_by_depth;
+
+    void count_call(int depth) {
+        if (depth >= (int)calls_by_depth.size()) calls_by_depth.resize(depth + 1, 0);
+        calls_by_depth[depth]++;
+    }
+
+    void merge(const HotPathCounters& other) {
+        pivot_scans += other.pivot_scans;
+        x_scans += other.x_scans;
+        p_scans += other.p_scans;
+        reorder_steps += other.reorder_steps;
+        restore_steps += other.restore_steps;
+        if (other.calls_by_depth.size() > calls_by_depth.size())
+            calls_by_depth.resize(other.calls_by_depth.size(), 0);
+        for (size_t d = 0; d < other.calls_by_depth.size(); d++)
+            calls_by_depth[d] += other.calls_by_depth[d];
+    }
+
+    void print(ostream& out) const {
+        long long calls = 0;
+        for (long long c : calls_by_depth) calls += c;
+        long long total = pivot_scans + x_scans + p_scans + reorder_steps + restore_steps;
+
+        out << "Hot-path counters:\n";
+        out << "  Recursive calls: " << calls << "\n";
+        const pair<const char*, long long> rows[] = {
+            {"Pivot scoring scans", pivot_scans},
+            {"X-partition scans", x_scans},
+            {"P-partition scans", p_scans},
+            {"Adjacency reorder steps", reorder_steps},
+            {"Adjacency restore steps", restore_steps},
+        };
+        for (const auto& row : rows) {
+            out << "  " << row.first << ": " << row.second;
+            if (total > 0) out << " (" << (row.second * 100.0 / total) << "%)";
+            out << "\n";
+        }
+        out << "  Calls by depth:";
+        for (size_t d = 0; d < calls_by_depth.size(); d++)
+            out << ' ' << d << ':' << calls_by_depth[d];
+        out << "\n";
+    }
+};
+
+// Shape of the search tree gathered on the fly, so untracked runs can report
+// what print_search_tree_stats reports for tracked ones without materializing
+// nodes. Sizes are bucketed by powers of two: 0, 1, 2-3, 4-7, ...
+struct SearchStats {
+    vector<long long> nodes_by_depth;
+    vector<long long> p_size_hist;
+    vector<long long> x_size_hist;
+    vector<long long> branching_hist;  // explored children per internal node
+    long long p_size_sum = 0;
+    long long x_size_sum = 0;
+    int max_p_size = 0;
+    int max_x_size = 0;
+    long long internal_nodes = 0;
+    long long explored_children = 0;
+    int max_branching = 0;
+    long long pivot_pruned_candidates = 0;
+    long long maximal_leaves = 0;
+    long long non_maximal_leaves = 0;
+
+    static int bucket(int v) { return v == 0 ? 0 : 32 - __builtin_clz(v); }
+
+    static void add(vector<long long>& hist, int idx) {
+        if (idx >= (int)hist.size()) hist.resize(idx + 1, 0);
+        hist[idx]++;
+    }
+
+    void record_node(int depth, int p_size, int x_size) {
+        add(nodes_by_depth, depth);
+        add(p_size_hist, bucket(p_size));
+        add(x_size_hist, bucket(x_size));
+        p_size_sum += p_size;
+        x_size_sum += x_size;
+        max_p_size = max(max_p_size, p_size);
+        max_x_size = max(max_x_size, x_size);
+    }
+
+    // A node whose P and X are both empty reports a maximal clique
+    void record_maximal_leaf() { maximal_leaves++; }
+
+    // Called once per non-maximal node after pivot selection; a node with no
+    // explored children is a dead end, i.e. a non-maximal leaf
+    void record_branching(int explored, int pruned) {
+        pivot_pruned_candidates += pruned;
+        if (explored == 0) {
+            non_maximal_leaves++;
+            return;
+        }
+        internal_nodes++;
+        explored_children += explored;
+        max_branching = max(max_branching, explored);
+        add(branching_hist, bucket(explored));
+    }
+
+    static void merge_hist(vector<long long>& into, const vector<long long>& from) {
+        if (from.size() > into.size()) into.resize(from.size(), 0);
+        for (size_t i = 0; i < from.size(); i++) into[i] += from[i];
+    }
+
+    void merge(const SearchStats& other) {
+        merge_hist(nodes_by_depth, other.nodes_by_depth);
+        merge_hist(p_size_hist, other.p_size_hist);
+        merge_hist(x_size_hist, other.x_size_hist);
+        merge_hist(branching_hist, other.branching_hist);
+        p_size_sum += other.p_size_sum;
+        x_size_sum += other.x_size_sum;
+        max_p_size = max(max_p_size, other.max_p_size);
+        max_x_size = max(max_x_size, other.max_x_size);
+        internal_nodes += other.internal_nodes;
+        explored_children += other.explored_children;
+        max_branching = max(max_branching, other.max_branching);
+        pivot_pruned_candidates += other.pivot_pruned_candidates;
+        maximal_leaves += other.maximal_leaves;
+        non_maximal_leaves += other.non_maximal_leaves;
+    }
+
+    static void print_hist(ostream& out, const char* name, const vector<long long>& hist) {
+        out << "  " << name << ":";
+        for (size_t i = 0; i < hist.size(); i++) {
+            if (hist[i] == 0) continue;
+            if (i == 0)
+                out << " 0:";
+            else if (i == 1)
+                out << " 1:";
+            else
+                out << ' ' << (1 << (i - 1)) << '-' << ((1 << i) - 1) << ':';
+            out << hist[i];
+        }
+        out << "\n";
+    }
+
+    void print(ostream& out) const {
+        long long nodes = 0;
+        for (long long c : nodes_by_depth) nodes += c;
+        long long leaves = maximal_leaves + non_maximal_leaves;
+
+        out << "Search Statistics (untracked):\n";
+        out << "  Total nodes: " << nodes << "\n";
+        out << "  Max depth: " << (nodes_by_depth.empty() ? 0 : (int)nodes_by_depth.size() - 1) << "\n";
+        out << "  Nodes by depth:";
+        for (size_t d = 0; d < nodes_by_depth.size(); d++)
+            out << ' ' << d << ':' << nodes_by_depth[d];
+        out << "\n";
+        if (nodes > 0) {
+            out << "  |P| mean: " << (double)p_size_sum / nodes << ", max: " << max_p_size << "\n";
+            out << "  |X| mean: " << (double)x_size_sum / nodes << ", max: " << max_x_size << "\n";
+        }
+        print_hist(out, "|P| distribution", p_size_hist);
+        print_hist(out, "|X| distribution", x_size_hist);
+        out << "  Internal nodes: " << internal_nodes << "\n";
+        if (internal_nodes > 0)
+            out << "  Branching factor mean: " << (double)explored_children / internal_nodes
+                << ", max: " << max_branching << "\n";
+        print_hist(out, "Branching distribution", branching_hist);
+        out << "  Pivot-pruned candidates: " << pivot_pruned_candidates << "\n";
+        out << "  Leaves: " << leaves << " (maximal: " << maximal_leaves
+            << ", non-maximal: " << non_maximal_leaves << ")\n";
+        if (leaves > 0)
+            out << "  Maximal leaf ratio: " << (maximal_leaves * 100.0 / leaves) << "%\n";
+    }
+};
+
+// Cost of one root subproblem of the outer Bron-Kerbosch loop
+struct RootProfile {
+    int rank;           // position in the root order
+    int vertex;
+    int p_size;
+    int x_size;
+    long long nodes;    // search tree nodes visited under this root
+    long long cliques;  // maximal cliques reported under this root
+    long long ns;       // wall time spent on this root
+};
+
+// Time split of one parallel worker over a run_roots call. Idle time is the
+// wall time of the whole parallel phase not spent setting up or searching
+// claimed roots: waiting for the last workers to finish, plus claim overhead.
+struct WorkerLoad {
+    long long setup_ns = 0;  // copying the graph into the worker
+    long long busy_ns = 0;   // searching claimed roots
+    long long idle_ns = 0;
+    long long claims = 0;    // root ranges taken from the shared counter
+    long long roots = 0;
+    long long nodes = 0;
+    int cpu = -1;            // pinned CPU and its NUMA node, -1 if not pinned
+    int node = -1;
+};
+
+inline void print_worker_loads(ostream& out, const vector<WorkerLoad>& loads) {
+    out << "Worker load:\n";
+    out << "  " << left << setw(10) << "worker" << right << setw(12) << "setup_ms" << setw(12) << "busy_ms"
+        << setw(12) << "idle_ms" << setw(8) << "idle%" << setw(10) << "claims" << setw(10) << "roots" << setw(14)
+        << "nodes" << "\n";
+    for (size_t t = 0; t < loads.size(); t++) {
+        const WorkerLoad& w = loads[t];
+        long long total = w.setup_ns + w.busy_ns + w.idle_ns;
+        out << "  " << left << setw(10) << t + 1 << right << fixed << setprecision(1) << setw(12) << w.setup_ns / 1e6
+            << setw(12) << w.busy_ns / 1e6 << setw(12) << w.idle_ns / 1e6 << setw(8)
+            << (total > 0 ? w.idle_ns * 100.0 / total : 0.0) << defaultfloat << setw(10) << w.claims << setw(10)
+            << w.roots << setw(14) << w.nodes << "\n";
+    }
+}
+
+// Search throughput of the workers pinned to each NUMA node. Workers whose
+// memory is remote run slower per node of search tree, which shows up as a
+// lower rate on their node.
+inline void print_node_throughput(ostream& out, const vector<WorkerLoad>& loads) {
+    map<int, WorkerLoad> per_node;
+    map<int, int> workers;
+    for (const WorkerLoad& w : loads) {
+        if (w.node < 0) continue;
+        WorkerLoad& sum = per_node[w.node];
+        sum.busy_ns += w.busy_ns;
+        sum.setup_ns += w.setup_ns;
+        sum.roots += w.roots;
+        sum.nodes += w.nodes;
+        workers[w.node]++;
+    }
+    if (per_node.empty()) return;
+    out << "Per-node throughput:\n";
+    out << "  " << left << setw(8) << "node" << right << setw(9) << "workers" << setw(12) << "setup_ms" << setw(12)
+        << "busy_ms" << setw(10) << "roots" << setw(14) << "nodes" << setw(16) << "knodes/busy_s" << "\n";
+    for (const auto& entry : per_node) {
+        const WorkerLoad& w = entry.second;
+        out << "  " << left << setw(8) << entry.first << right << setw(9) << workers[entry.first] << fixed
+            << setprecision(1) << setw(12) << w.setup_ns / 1e6 << setw(12) << w.busy_ns / 1e6 << defaultfloat
+            << setw(10) << w.roots << setw(14) << w.nodes << fixed << setprecision(1) << setw(16)
+            << (w.busy_ns > 0 ? w.nodes * 1e6 / w.busy_ns : 0.0) << defaultfloat << "\n";
+    }
+}
+
+#endif
@@ -1,17 +1,200 @@
 #include <chrono>
 
+#include "autotune.h"
+#include "clique_graph.h"
+#include "config.h"
+#include "cpm.h"
+#include "generators.h"
 #include "graph.h"
+#include "progress.h"
 
 using namespace std;
 
+// SIGINT/SIGTERM raise the run's stop flag; the engine stops at the next
+// search tree node and the partial results are reported as usual. The
+// handler resets itself, so a second signal terminates immediately.
+static RunControl* signal_control = nullptr;
+static volatile sig_atomic_t stop_signal = 0;
+
+extern "C" void handle_stop_signal(int signo) {
+    stop_signal = signo;
+    if (signal_control) signal_control->stop.store(true);
+}
+
+static void install_stop_handlers(RunControl* control) {
+    signal_control = control;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop_signal;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+// ./main --generate <model> [options]: write a synthetic graph and exit
+int generate_main(int argc, char* argv[]) {
+    GeneratorParams params;
+    params.model = argc > 2 ? argv[2] : "";
+    string output;
+    string format = "text";
+
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << arg << " requires a value\n";
+            return 1;
+        }
+        string value = argv[++i];
+        if (arg == "--scale") {
+            params.scale = atoi(value.c_str());
+        } else if (arg == "--edge-factor") {
+            params.edge_factor = atoi(value.c_str());
+        } else if (arg == "--rmat") {
+            if (sscanf(value.c_str(), "%lf,%lf,%lf", &params.a, &params.b, &params.c) != 3) {
+                cerr << "--rmat expects a,b,c\n";
+                return 1;
+            }
+        } else if (arg == "--vertices") {
+            params.vertices = atoi(value.c_str());
+        } else if (arg == "--prob") {
+            params.prob = atof(value.c_str());
+        } else if (arg == "--attach") {
+            params.attach = atoi(value.c_str());
+        } else if (arg == "--clique") {
+            params.clique = atoi(value.c_str());
+        } else if (arg == "--seed") {
+            params.seed = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--threads" || arg == "-t") {
+            params.threads = max(1, atoi(value.c_str()));
+        } else if (arg == "--output" || arg == "-o") {
+            output = value;
+        } else if (arg == "--format") {
+            format = value;
+        } else {
+            cerr << "Unknown generator option " << arg << "\n";
+            return 1;
+        }
+    }
+    if (format != "text" && format != "csr") {
+        cerr << "--format must be text or csr\n";
+        return 1;
+    }
+    if (format == "csr" && output.empty()) {
+        cerr << "--format csr requires --output\n";
+        return 1;
+    }
+
+    string param_error = generator_param_error(params);
+    if (!param_error.empty()) {
+        cerr << param_error << "\n";
+        return 1;
+    }
+
+    vector<pair<int, int>> edges;
+    if (!generate_graph(params, edges)) {
+        cerr << "Unknown model '" << params.model << "' (rmat, er, ba, planted, moon-moser)\n";
+        return 1;
+    }
+    int n = generator_vertices(params);
+
+    bool ok;
+    if (format == "csr") {
+        ok = write_csr_file(output, n, edges);
+    } else if (output.empty()) {
+        ok = write_edge_list(cout, n, edges);
+    } else {
+        ofstream out(output);
+        ok = out.is_open() && write_edge_list(out, n, edges);
+    }
+    if (!ok) {
+        cerr << "Error writing graph\n";
+        return 1;
+    }
+    if (!output.empty()) cout << "Generated " << params.model << " graph: " << n << " vertices, " << edges.size() << " edges -> " << output << "\n";
+    return 0;
+}
+
+// ./main --query <base> <vertex>...: print the maximal cliques containing
+// each vertex from a clique store written by --clique-index
+int query_main(int argc, char* argv[]) {
+    if (argc < 4) {
+        cerr << "--query requires a clique store and at least one vertex\n";
+        return 1;
+    }
+    CliqueIndex index;
+    string error;
+    if (!index.open(argv[2], error)) {
+        cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    cout << "Clique store " << argv[2] << ": " << index.num_cliques() << " cliques over " << index.num_vertices()
+         << " vertices\n";
+    for (int i = 3; i < argc; i++) {
+        char* end;
+        long long v = strtoll(argv[i], &end, 10);
+        if (*end || v < 0 || v >= index.num_vertices()) {
+            cerr << "Error: " << argv[i] << " is not a vertex of the graph\n";
+            return 1;
+        }
+        // Time the lookup and the walk over the cliques' vertices, not the printing
+        auto start = chrono::steady_clock::now();
+        Span<const unsigned> ids = index.cliques_of(v);
+        unsigned long long checksum = 0;
+        for (unsigned id : ids)
+            for (unsigned u : index.clique(id)) checksum += u;
+        double us = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count() / 1e3;
+        cout << "Vertex " << v << ": " << ids.size() << " maximal cliques (" << us << " us, " << checksum
+             << " vertex id sum)\n";
+        for (unsigned id : ids) {
+            cout << "  " << id << ":";
+            for (unsigned u : index.clique(id)) cout << ' ' << u;
+            cout << "\n";
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
 
+    if (argc > 1 && string(argv[1]) == "--generate") return generate_main(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--query") return query_main(argc, argv);
+
     // Check if CSV export is requested
     bool export_csv = false;
     string csv_filename = "search_tree.csv";
-    bool use_degeneracy = true;  // Use degeneracy ordering by default
+    EngineConfig config;  // degeneracy ordering, Tomita pivot by default
+    bool hot_path_counters = false;
+    bool search_stats = false;
+    string root_profile_filename;
+    int num_threads = 1;
+    string trace_filename;
+    size_t trace_events = TraceWriter::kDefaultEvents;
+    bool perf_counters = false;
+    string input_filename;
+    double estimate_ms = 0;  // > 0 runs the cost estimate instead of the search
+    bool autotune = false;
+    string autotune_filename;
+    double time_limit_s = 0;
+    string checkpoint_filename;
+    double checkpoint_interval_s = 60;
+    bool resume = false;
+    double progress_s = 0;  // > 0 prints progress to stderr at this interval
+    long long memory_limit = 0;  // bytes, 0 = unlimited
+    bool memory_report = false;
+    string pin_policy;  // compact or scatter; empty leaves threads unpinned
+    bool numa_interleave = false;
+    bool huge_page_report = false;
+    bool compressed = false;
+    long long external_batch = 0;  // > 0 leaves the graph on disk (binary CSR)
+    double peel_epsilon = 0.1;
+    string clique_index;  // base name of the clique store, empty for none
+    int cpm_k = 0;  // > 0 finds the k-clique communities
+    string cpm_filename = "communities.txt";
+    int overlap_t = 0;  // > 0 builds the clique overlap graph
+    string overlap_filename = "clique_graph.csr";
 
     for (int i = 1; i < argc; i++) {
         string arg = argv[i];
@@ -21,43 +204,580 @@ int main(int argc, char* argv[]) {
                 csv_filename = argv[++i];
             }
         } else if (arg == "--no-degeneracy" || arg == "-n") {
-            use_degeneracy = false;
+            config.degeneracy = false;
+        } else if (arg == "--hot-path-counters" || arg == "-c") {
+            hot_path_counters = true;
+        } else if (arg == "--search-stats" || arg == "-s") {
+            search_stats = true;
+        } else if (arg == "--root-profile") {
+            if (i + 1 < argc) {
+                root_profile_filename = argv[++i];
+            } else {
+                cerr << "--root-profile requires a file name\n";
+                return 1;
+            }
+        } else if (arg == "--threads" || arg == "-t") {
+            if (i + 1 < argc) {
+                num_threads = max(1, atoi(argv[++i]));
+            } else {
+                cerr << "--threads requires a thread count\n";
+                return 1;
+            }
+        } else if (arg == "--trace") {
+            if (i + 1 < argc) {
+                trace_filename = argv[++i];
+            } else {
+                cerr << "--trace requires a file name\n";
+                return 1;
+            }
+        } else if (arg == "--trace-events") {
+            if (i + 1 < argc) {
+                trace_events = max(1LL, atoll(argv[++i]));
+            } else {
+                cerr << "--trace-events requires an event count\n";
+                return 1;
+            }
+        } else if (arg == "--perf") {
+            perf_counters = true;
+        } else if (arg == "--estimate") {
+            estimate_ms = 250;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                estimate_ms = max(1.0, atof(argv[++i]));
+            }
+        } else if (arg == "--pivot" || arg == "--grain" || arg == "--hubs") {
+            if (i + 1 >= argc) {
+                cerr << arg << " requires a value\n";
+                return 1;
+            }
+            if (!config.set(arg.substr(2), argv[++i])) return 1;
+        } else if (arg == "--config") {
+            if (i + 1 >= argc) {
+                cerr << "--config requires a file name\n";
+                return 1;
+            }
+            if (!config.load(argv[++i])) return 1;
+        } else if (arg == "--autotune") {
+            autotune = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                autotune_filename = argv[++i];
+            }
+        } else if (arg == "--time-limit" || arg == "--checkpoint-interval") {
+            if (i + 1 >= argc || atof(argv[i + 1]) <= 0) {
+                cerr << arg << " requires a positive number of seconds\n";
+                return 1;
+            }
+            (arg == "--time-limit" ? time_limit_s : checkpoint_interval_s) = atof(argv[++i]);
+        } else if (arg == "--checkpoint") {
+            if (i + 1 < argc) {
+                checkpoint_filename = argv[++i];
+            } else {
+                cerr << "--checkpoint requires a file name\n";
+                return 1;
+            }
+        } else if (arg == "--progress") {
+            progress_s = 5;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                progress_s = max(0.1, atof(argv[++i]));
+            }
+        } else if (arg == "--memory-limit") {
+            memory_limit = i + 1 < argc ? parse_byte_size(argv[++i]) : -1;
+            if (memory_limit <= 0) {
+                cerr << "--memory-limit requires a size such as 512M or 2G\n";
+                return 1;
+            }
+            memory_report = true;
+        } else if (arg == "--pin-threads") {
+            pin_policy = "scatter";
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                pin_policy = argv[++i];
+            }
+            if (pin_policy != "compact" && pin_policy != "scatter") {
+                cerr << "--pin-threads must be compact or scatter\n";
+                return 1;
+            }
+        } else if (arg == "--numa-interleave") {
+            numa_interleave = true;
+        } else if (arg == "--huge-pages") {
+            string mode = i + 1 < argc ? argv[++i] : "";
+            if (mode == "thp")
+                HugePages::set_mode(HugePages::THP);
+            else if (mode == "hugetlb")
+                HugePages::set_mode(HugePages::HUGETLB);
+            else if (mode == "off")
+                HugePages::set_mode(HugePages::OFF);
+            else {
+                cerr << "--huge-pages must be thp, hugetlb or off\n";
+                return 1;
+            }
+            huge_page_report = true;
+        } else if (arg == "--peel-epsilon") {
+            if (i + 1 >= argc || atof(argv[i + 1]) <= 0) {
+                cerr << "--peel-epsilon requires a positive number\n";
+                return 1;
+            }
+            peel_epsilon = atof(argv[++i]);
+        } else if (arg == "--clique-index") {
+            if (i + 1 < argc) {
+                clique_index = argv[++i];
+            } else {
+                cerr << "--clique-index requires a base file name\n";
+                return 1;
+            }
+        } else if (arg == "--cpm") {
+            if (i + 1 >= argc || atoi(argv[i + 1]) < 2) {
+                cerr << "--cpm requires a clique size k of at least 2\n";
+                return 1;
+            }
+            cpm_k = atoi(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                cpm_filename = argv[++i];
+            }
+        } else if (arg == "--clique-graph") {
+            if (i + 1 >= argc || atoi(argv[i + 1]) < 1) {
+                cerr << "--clique-graph requires an overlap t of at least 1\n";
+                return 1;
+            }
+            overlap_t = atoi(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                overlap_filename = argv[++i];
+            }
+        } else if (arg == "--compressed") {
+            compressed = true;
+        } else if (arg == "--external") {
+            external_batch = 64 << 20;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                external_batch = parse_byte_size(argv[++i]);
+                if (external_batch <= 0) {
+                    cerr << "--external takes a batch size such as 64M\n";
+                    return 1;
+                }
+            }
+        } else if (arg == "--memory-report") {
+            memory_report = true;
+        } else if (arg == "--resume") {
+            resume = true;
+        } else if (arg == "--input" || arg == "-i") {
+            if (i + 1 < argc) {
+                input_filename = argv[++i];
+            } else {
+                cerr << "--input requires a file name\n";
+                return 1;
+            }
         }
     }
 
-    Graph g;
-    if (!g.readGraph()) {
-        cerr << "Error reading graph\n";
+    if (compressed && (export_csv || estimate_ms > 0 || autotune)) {
+        cerr << "--compressed supports the enumeration only, not --export-tree, --estimate or --autotune\n";
         return 1;
     }
+    if (external_batch > 0) {
+        if (compressed || export_csv || estimate_ms > 0 || autotune) {
+            cerr << "--external supports the enumeration only, not --compressed, --export-tree, --estimate or --autotune\n";
+            return 1;
+        }
+        if (input_filename.empty() || !is_csr_file(input_filename)) {
+            cerr << "--external requires a binary CSR input file (see --generate --format csr)\n";
+            return 1;
+        }
+    }
+
+    // Under a memory limit the trace rings get at most 1/16 of it
+    unique_ptr<TraceWriter> trace;
+    if (!trace_filename.empty()) {
+        size_t events = trace_events;
+        if (memory_limit > 0)
+            events = max<long long>(1024, min<long long>(events, memory_limit / 16 / (num_threads + 1) / sizeof(TraceEvent)));
+        trace.reset(new TraceWriter(events));
+    }
+    if (trace) trace->ensure_threads(1);
+
+    // Hardware counters per phase; fall back to running without them when
+    // perf_event is not permitted (e.g. containers)
+    unique_ptr<PerfReport> perf;
+    if (perf_counters) {
+        PerfCounters probe;
+        if (probe.available()) {
+            perf.reset(new PerfReport());
+        } else {
+            cout << "Hardware counters unavailable (" << probe.error() << "), continuing without them\n";
+        }
+    }
+
+    // The graph and ordering that workers copy from are read by every node;
+    // interleaving spreads them over the memory controllers. Worker copies
+    // are made after the policy is reset, so they stay local.
+    NumaTopology topology;
+    if (!pin_policy.empty() || numa_interleave) topology = NumaTopology::detect();
+    if (numa_interleave) {
+        if (topology.num_nodes() < 2) {
+            cout << "One NUMA node, nothing to interleave\n";
+            numa_interleave = false;
+        } else if (!set_interleave_policy(topology.num_nodes())) {
+            cout << "Could not set an interleaved memory policy (" << strerror(errno) << "), continuing without it\n";
+            numa_interleave = false;
+        }
+    }
+
+    MemoryLedger memory;
+    Graph g;
+    g.set_memory_ledger(&memory);
+    {
+        TraceScope phase(trace.get(), 0, "parse");
+        PerfPhase perf_phase(perf.get(), "parse");
+        bool ok = external_batch > 0 ? g.openExternal(input_filename, external_batch)
+                  : input_filename.empty() ? g.readGraph()
+                                           : g.readGraphFile(input_filename, compressed);
+        if (!ok) {
+            cerr << "Error reading graph\n";
+            return 1;
+        }
+        if (compressed && !g.is_compressed()) g.compress_adjacency();
+    }
+    if (compressed) {
+        long long entries = 2LL * g.numEdges();
+        long long plain = sizeof(long long) * (g.numVertices() + 1LL) + sizeof(int) * (entries + g.numVertices());
+        ostringstream ratio;
+        ratio << fixed << setprecision(1) << (entries ? g.graph_bytes() * 8.0 / entries : 0.0) << " bits per entry, "
+              << (g.graph_bytes() ? (double)plain / g.graph_bytes() : 0.0) << "x smaller than CSR";
+        cout << "Compressed adjacency: " << MemoryLedger::format_bytes(g.graph_bytes()) << " (" << ratio.str() << ")\n";
+    }
     // g.printGraph();
+    if (!compressed && external_batch == 0) {
+        g.build_hub_rows(config.hubs);
+        if (const HubRows* hubs = g.hubs())
+            cout << "Hub rows: " << hubs->num_hubs() << " vertices of degree >= " << hubs->threshold() << ", "
+                 << hubs->num_containers() << " containers (" << hubs->num_bitmap_containers() << " bitmaps), "
+                 << MemoryLedger::format_bytes(hubs->bytes()) << "\n";
+    }
+    memory.set(MemoryLedger::GRAPH, g.graph_bytes());
+
+    if (estimate_ms > 0) {
+        SearchEstimate est;
+        if (config.degeneracy) {
+            auto order_start = chrono::high_resolution_clock::now();
+            g.dgn_order_cal();
+            chrono::duration<double> order_elapsed = chrono::high_resolution_clock::now() - order_start;
+            cout << "Degeneracy ordering: " << order_elapsed.count() * 1000 << " ms\n";
+            est = g.estimate_degeneracy(estimate_ms);
+        } else {
+            est = g.estimate_basic(estimate_ms);
+        }
+        est.print(cout);
+        return 0;
+    }
+
+    if (autotune) {
+        EngineConfig tuned = autotune_engine(g, config, num_threads, cout);
+        if (autotune_filename.empty()) {
+            tuned.write(cout);
+        } else if (tuned.save(autotune_filename, "Tuned on " + (input_filename.empty() ? string("stdin") : input_filename) +
+                                                    " with " + to_string(num_threads) + " thread(s)")) {
+            cout << "Configuration saved to " << autotune_filename << " (use with --config)\n";
+        } else {
+            return 1;
+        }
+        return 0;
+    }
+    g.set_pivot_from_p(config.pivot_from_p);
+    g.set_root_grain(config.grain);
+
+    // Stop flag, time limit and checkpoints; progress is recorded per
+    // completed root
+    unique_ptr<RunControl> control(new RunControl(g.numVertices()));
+    if (resume && checkpoint_filename.empty()) {
+        cerr << "--resume requires --checkpoint <file>\n";
+        return 1;
+    }
+    if (resume && (!clique_index.empty() || cpm_k > 0 || overlap_t > 0)) {
+        cerr << (cpm_k > 0 ? "--cpm" : overlap_t > 0 ? "--clique-graph" : "--clique-index")
+             << " is not supported with --resume, the cliques of the earlier run are not stored\n";
+        return 1;
+    }
+    if (!checkpoint_filename.empty()) {
+        if (export_csv) {
+            cerr << "--checkpoint is not supported with --export-tree\n";
+            return 1;
+        }
+        // The external ordering is a different order, fixed by epsilon
+        string ordering = config.ordering_name();
+        if (external_batch > 0 && config.degeneracy) {
+            ostringstream name;
+            name << "peeled-degeneracy-" << peel_epsilon;
+            ordering = name.str();
+        }
+        control->set_checkpoint(checkpoint_filename, checkpoint_interval_s, g.fingerprint(), ordering);
+        if (resume) {
+            if (!control->load_checkpoint(checkpoint_filename)) return 1;
+            cout << "Resuming from " << checkpoint_filename << ": " << control->completed_roots() << " of "
+                 << control->num_roots() << " roots done, " << control->completed_cliques() << " cliques\n";
+            g.clique_count = control->completed_cliques();
+            g.node_visits = control->completed_nodes();
+        }
+    }
+    control->set_time_limit(time_limit_s);
+    g.set_run_control(control.get());
 
     // Enable search tree tracking if export is requested
     if (export_csv) {
         g.enable_search_tree_tracking();
         cout << "Search tree tracking enabled\n";
+        if (num_threads > 1) {
+            cout << "Search tree tracking is sequential, ignoring --threads\n";
+            num_threads = 1;
+        }
+    }
+
+    g.set_external_epsilon(peel_epsilon);
+    if (external_batch > 0 && num_threads > 1) {
+        cout << "External mode searches on one thread, ignoring --threads\n";
+        num_threads = 1;
     }
 
+    // Fit the run into --memory-limit: fewer worker copies of the graph,
+    // smaller external batches, and the search tree spilled to disk past
+    // what is left
+    if (memory_limit > 0) {
+        long long ordering = config.degeneracy ? 2LL * sizeof(int) * g.numVertices() : 0;
+        long long fixed_bytes = memory.current[MemoryLedger::GRAPH] + ordering + g.search_state_bytes() +
+                                (trace ? (long long)(num_threads + 1) * trace->max_bytes_per_thread() : 0);
+        long long available = memory_limit - fixed_bytes;
+        if (available < 0)
+            cout << "Memory limit " << MemoryLedger::format_bytes(memory_limit) << " is below the "
+                 << MemoryLedger::format_bytes(fixed_bytes) << " the graph and ordering need, continuing\n";
+        if (num_threads > 1) {
+            long long per_worker = g.worker_bytes(config.degeneracy);
+            int fit = (int)min<long long>(num_threads, max(0LL, available) / per_worker);
+            if (fit < num_threads) {
+                num_threads = max(1, fit);
+                cout << "Memory limit: worker graph copies take " << MemoryLedger::format_bytes(per_worker)
+                     << " each, using " << num_threads << " thread" << (num_threads > 1 ? "s" : "") << "\n";
+            }
+        }
+        if (export_csv)
+            g.set_tracking_budget(max(1LL, available - AsyncOutput::buffer_bytes()), csv_filename + ".spill");
+        // Three batches may be in memory at once (see run_external_roots)
+        if (external_batch > 0 && 3 * external_batch > available) {
+            g.set_external_batch_bytes(max(1LL << 20, available / 3));
+            cout << "Memory limit: external batches of " << MemoryLedger::format_bytes(g.get_external_batch_bytes()) << "\n";
+        }
+    }
+
+    if (!pin_policy.empty()) {
+        vector<int> cpus = topology.assign_cpus(num_threads, pin_policy == "scatter");
+        vector<int> nodes;
+        for (int cpu : cpus) nodes.push_back(topology.node_of_cpu(cpu));
+        cout << "Pinning " << num_threads << " thread" << (num_threads > 1 ? "s" : "") << " (" << pin_policy << " over "
+             << topology.num_nodes() << " NUMA node" << (topology.num_nodes() > 1 ? "s" : "") << ") to CPUs";
+        for (int cpu : cpus) cout << ' ' << cpu;
+        cout << "\n";
+        if (num_threads > 1)
+            g.set_worker_placement(cpus, nodes);
+        else if (!cpus.empty())
+            pin_current_thread(cpus[0]);
+    }
+    g.set_trace(trace.get());
+    if (perf && num_threads > 1) {
+        g.enable_thread_perf();
+    }
+    if (hot_path_counters) {
+        g.enable_hot_path_counters();
+    }
+    if (search_stats) {
+        g.enable_search_stats();
+    }
+    if (!root_profile_filename.empty()) {
+        g.enable_root_profile();
+    }
+    // Clique percolation and the overlap graph read the cliques from a
+    // store, a temporary one unless --clique-index keeps it
+    bool temporary_store = (cpm_k > 0 || overlap_t > 0) && clique_index.empty();
+    if (temporary_store) clique_index = (cpm_k > 0 ? cpm_filename : overlap_filename) + ".store";
+    unique_ptr<TemporaryCliqueStore> store_files;
+    if (temporary_store) store_files.reset(new TemporaryCliqueStore(clique_index));
+    shared_ptr<CliqueStore> store;
+    if (!clique_index.empty()) {
+        store.reset(new CliqueStore(clique_index, num_threads + 1));
+        g.set_clique_store(store);
+    }
+
+    install_stop_handlers(control.get());
     auto start = chrono::high_resolution_clock::now();
-    if (use_degeneracy) {
+    control->start();
+    if (config.degeneracy) {
         cout << "Using degeneracy ordering\n";
+        TraceScope phase(trace.get(), 0, "ordering");
+        PerfPhase perf_phase(perf.get(), "ordering");
         g.dgn_order_cal();
-        g.bron_kerbosch_degeneracy();
     } else {
         cout << "Using basic Bron-Kerbosch (no degeneracy ordering)\n";
-        g.bron_kerbosch_basic();
     }
+    if (numa_interleave) set_interleave_policy(0);
+    unique_ptr<ProgressReporter> progress;
+    if (progress_s > 0) {
+        control->set_root_costs(g.estimated_root_costs(config.degeneracy));
+        progress.reset(new ProgressReporter(*control, progress_s));
+        progress->start();
+    }
+    {
+        TraceScope phase(trace.get(), 0, "enumeration");
+        PerfPhase perf_phase(perf.get(), num_threads > 1 ? "enumeration (main)" : "enumeration");
+        if (config.degeneracy)
+            g.bron_kerbosch_degeneracy(num_threads);
+        else
+            g.bron_kerbosch_basic(num_threads);
+    }
+    if (progress) progress->stop();
     auto end = chrono::high_resolution_clock::now();
     chrono::duration<double> elapsed = end - start;
 
+    control->finish();
+    bool incomplete = control->completed_roots() < control->num_roots();
+    if (incomplete) {
+        if (stop_signal)
+            cout << "Interrupted by " << (stop_signal == SIGINT ? "SIGINT" : "SIGTERM");
+        else
+            cout << (control->hit_time_limit() ? "Time limit reached" : "Run stopped");
+        cout << ": " << control->completed_roots() << " of " << control->num_roots()
+             << " roots completed, partial results follow\n";
+    }
+    if (!checkpoint_filename.empty() && control->write_checkpoint())
+        cout << "Checkpoint written to " << checkpoint_filename << "\n";
+
+    if (num_threads > 1) cout << "Threads: " << num_threads << "\n";
     cout << "Clique count: " << g.clique_count << "\n";
     cout << "Elapsed Time: " << elapsed.count() * 1000 << " ms\n";
+    if (g.is_external()) {
+        const ExternalStats& io = g.external_run_stats();
+        const ExternalOrderStats& peel = g.external_order_stats();
+        if (io.failed || peel.failed) {
+            cerr << "Error reading " << input_filename << " during the " << (peel.failed ? "ordering" : "search") << "\n";
+            return 1;
+        }
+        if (config.degeneracy)
+            cout << "External ordering: " << peel.passes << " passes, " << MemoryLedger::format_bytes(peel.bytes_read)
+                 << " read, at most " << peel.max_later << " later neighbors per vertex\n";
+        ostringstream line;
+        line << fixed << setprecision(2) << "External I/O: " << io.batches << " batches, " << io.rows << " lists ("
+             << (g.numVertices() ? (double)io.rows / g.numVertices() : 0.0) << " per vertex), "
+             << MemoryLedger::format_bytes(io.bytes_read) << " in " << io.reads << " reads, I/O thread "
+             << io.io_ns / 1e6 << " ms, search waited " << io.stall_ns / 1e6 << " ms";
+        cout << line.str() << "\n";
+    }
+    if (!g.worker_loads().empty()) {
+        print_worker_loads(cout, g.worker_loads());
+        print_node_throughput(cout, g.worker_loads());
+    }
+    if (hot_path_counters) {
+        g.hot_path_counters().print(cout);
+    }
+    if (search_stats) {
+        g.search_stats().print(cout);
+    }
+    if (!root_profile_filename.empty()) {
+        g.export_root_profile_to_csv(root_profile_filename);
+    }
+    // A failed clique output skips what depends on it; the run still exports
+    // the rest and exits with status 1
+    bool output_failed = false;
+    if (store) {
+        CliqueStoreStats cs;
+        memory.touch(MemoryLedger::OUTPUT, store->buffer_bytes());
+        if (store->finish(g.numVertices(), num_threads, cs)) {
+            memory.touch(MemoryLedger::OUTPUT, cs.scratch_bytes);
+            ostringstream line;
+            line << fixed << setprecision(1) << "Clique store: " << cs.cliques << " cliques, " << cs.entries << " entries -> "
+                 << CliqueStore::cliques_path(clique_index) << " (" << MemoryLedger::format_bytes(cs.cliques_bytes) << "), "
+                 << CliqueStore::postings_path(clique_index) << " (" << MemoryLedger::format_bytes(cs.postings_bytes)
+                 << "); merged in " << cs.merge_ns / 1e6 << " ms, postings in " << cs.index_ns / 1e6 << " ms on "
+                 << cs.threads << " thread" << (cs.threads > 1 ? "s" : "");
+            cout << line.str() << "\n";
+            cout << "  Spool output: " << cs.spools.summary() << "\n";
+        } else {
+            output_failed = true;
+        }
+    }
+    // --cpm and --clique-graph only need the store, not each other
+    bool store_failed = output_failed;
+    if (cpm_k > 0 && !store_failed) {
+        CliqueIndex index;
+        string error;
+        CpmStats cpm;
+        OutputStats io;
+        if (!index.open(clique_index, error)) {
+            cerr << "Error: " << error << "\n";
+            output_failed = true;
+        } else {
+            vector<vector<unsigned>> communities = CliquePercolation(index, cpm_k).run(num_threads, cpm);
+            memory.touch(MemoryLedger::OUTPUT, cpm.scratch_bytes);
+            output_failed = !CliquePercolation::write(cpm_filename, communities, io);
+        }
+        if (!output_failed) {
+            ostringstream line;
+            line << fixed << setprecision(1) << "Clique percolation (k = " << cpm.k << "): " << cpm.communities
+                 << " communities from " << cpm.cliques << " cliques of " << cpm.k << "+ vertices, largest " << cpm.largest
+                 << " vertices, " << cpm.covered << " vertices covered; " << cpm.grouped << " entries grouped, "
+                 << cpm.scanning << " cliques scanning (" << cpm.candidates << " pairs met, " << cpm.checked
+                 << " intersected), " << cpm.unions << " unions in " << cpm.ns / 1e6 << " ms on "
+                 << cpm.threads << " thread" << (cpm.threads > 1 ? "s" : "");
+            cout << line.str() << "\n";
+            cout << "Communities written to " << cpm_filename << "\n";
+            cout << "  Output: " << io.summary() << "\n";
+        }
+    }
+    if (overlap_t > 0 && !store_failed) {
+        CliqueIndex index;
+        string error;
+        CliqueGraphStats cg;
+        bool written = false;
+        if (!index.open(clique_index, error))
+            cerr << "Error: " << error << "\n";
+        else
+            written = CliqueOverlapGraph(index, overlap_t).write(overlap_filename, num_threads, cg);
+        if (written) {
+            memory.touch(MemoryLedger::OUTPUT, cg.scratch_bytes);
+            ostringstream line;
+            line << fixed << setprecision(1) << "Clique overlap graph (t = " << cg.t << "): " << cg.nodes << " cliques, "
+                 << cg.edges << " edges, max degree " << cg.max_degree << ", " << cg.isolated << " isolated; "
+                 << cg.prefix_entries << " prefix entries, " << cg.candidates << " pairs met, " << cg.windows << " windows of at most "
+                 << MemoryLedger::format_bytes(cg.window_bytes) << " in " << cg.ns / 1e6 << " ms on " << cg.threads
+                 << " thread" << (cg.threads > 1 ? "s" : "");
+            cout << line.str() << "\n";
+            cout << "Clique graph written to " << overlap_filename << "\n";
+            cout << "  Output: " << cg.io.summary() << "\n";
+        } else {
+            output_failed = true;
+        }
+    }
+    store_files.reset();
 
     // Export search tree if requested
     if (export_csv) {
         g.print_search_tree_stats();
-        g.export_search_tree_to_csv(csv_filename);
+        TraceScope phase(trace.get(), 0, "export");
+        PerfPhase perf_phase(perf.get(), "export");
+        g.export_search_tree_to_csv(csv_filename, incomplete);
     }
 
-    return 0;
+    if (memory_report) {
+        memory.set(MemoryLedger::OUTPUT, (trace ? trace->bytes() : 0) + g.root_profile_bytes());
+        memory.print(cout);
+    }
+    if (memory_report || huge_page_report) HugePages::print_report(cout);
+
+    if (perf) {
+        const vector<PerfSample>& per_thread = g.thread_perf_samples();
+        PerfSample all_threads;
+        for (size_t t = 0; t < per_thread.size(); t++) {
+            perf->add("enumeration thread " + to_string(t + 1), per_thread[t]);
+            all_threads.merge(per_thread[t]);
+        }
+        if (!per_thread.empty()) perf->add("enumeration (workers)", all_threads);
+        perf->print(cout);
+    }
+
+    if (trace) trace->write_json(trace_filename);
+
+    if (stop_signal) return 128 + stop_signal;
+    if (output_failed) return 1;
+    return incomplete ? 2 : 0;
 }
@@ -0,0 +1,89 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Bytes held by the engine's main data structures, current and peak per
+// component. Sizes are computed from container capacities at the points
+// where they change, not by hooking the allocator, so they cover what the
+// engine keeps rather than every temporary of the standard library.
+struct MemoryLedger {
+    enum Component { GRAPH, ORDERING, SEARCH_STATE, WORKERS, TRACKING, OUTPUT, NUM_COMPONENTS };
+    long long current[NUM_COMPONENTS] = {0, 0, 0, 0, 0, 0};
+    long long peak[NUM_COMPONENTS] = {0, 0, 0, 0, 0, 0};
+
+    static const char* name(int c) {
+        static const char* names[] = {"graph", "ordering", "search state", "worker copies", "tracking", "output buffers"};
+        return names[c];
+    }
+
+    void set(Component c, long long bytes) {
+        current[c] = bytes;
+        peak[c] = max(peak[c], bytes);
+    }
+
+    void add(Component c, long long delta) { set(c, current[c] + delta); }
+
+    // Peak of a temporary that is released again, e.g. ordering scratch space
+    void touch(Component c, long long bytes) { peak[c] = max(peak[c], current[c] + bytes); }
+
+    long long total_current() const {
+        long long sum = 0;
+        for (long long b : current) sum += b;
+        return sum;
+    }
+
+    // kB value of a /proc/self/status field such as VmHWM, or -1
+    static long long proc_status_kb(const string& field) {
+        ifstream in("/proc/self/status");
+        string line;
+        while (getline(in, line))
+            if (line.compare(0, field.size() + 1, field + ":") == 0) return atoll(line.c_str() + field.size() + 1);
+        return -1;
+    }
+
+    static string format_bytes(long long bytes) {
+        ostringstream out;
+        out << fixed << setprecision(1);
+        if (bytes >= (1LL << 30))
+            out << bytes / double(1LL << 30) << " GB";
+        else if (bytes >= (1LL << 20))
+            out << bytes / double(1LL << 20) << " MB";
+        else if (bytes >= (1LL << 10))
+            out << bytes / double(1LL << 10) << " KB";
+        else
+            out << bytes << " B";
+        return out.str();
+    }
+
+    void print(ostream& out) const {
+        out << "Memory:\n";
+        out << "  " << left << setw(16) << "component" << right << setw(12) << "current" << setw(12) << "peak" << "\n";
+        long long peak_sum = 0;
+        for (int c = 0; c < NUM_COMPONENTS; c++) {
+            out << "  " << left << setw(16) << name(c) << right << setw(12) << format_bytes(current[c]) << setw(12)
+                << format_bytes(peak[c]) << "\n";
+            peak_sum += peak[c];
+        }
+        out << "  " << left << setw(16) << "sum of peaks" << right << setw(24) << format_bytes(peak_sum) << "\n";
+        long long hwm = proc_status_kb("VmHWM");
+        if (hwm >= 0) out << "  Peak RSS (VmHWM): " << format_bytes(hwm * 1024) << "\n";
+    }
+};
+
+// "512M", "2G", "1500000" -> bytes; -1 if malformed
+inline long long parse_byte_size(const string& text) {
+    char* end = nullptr;
+    double value = strtod(text.c_str(), &end);
+    if (end == text.c_str() || value <= 0) return -1;
+    string suffix(end);
+    if (suffix.empty() || suffix == "B") return (long long)value;
+    const string units = "KMGT";
+    size_t u = units.find(toupper(suffix[0]));
+    if (u == string::npos || (suffix.size() > 1 && suffix.substr(1) != "B" && suffix.substr(1) != "iB")) return -1;
+    return (long long)(value * pow(1024.0, u + 1));
+}
+
+#endif
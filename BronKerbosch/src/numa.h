@@ -0,0 +1,114 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <bits/stdc++.h>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+// NUMA topology from sysfs and the few placement calls the engine needs,
+// made directly so that libnuma is not required. Without sysfs NUMA
+// information the machine is treated as one node holding every CPU this
+// process may run on.
+struct NumaTopology {
+    vector<vector<int>> node_cpus;  // allowed CPUs of each node with any
+
+    // "0-3,8-11" -> {0, 1, 2, 3, 8, 9, 10, 11}
+    static vector<int> parse_cpu_list(const string& text) {
+        vector<int> cpus;
+        stringstream in(text);
+        string range;
+        while (getline(in, range, ',')) {
+            int first, last;
+            int fields = sscanf(range.c_str(), "%d-%d", &first, &last);
+            if (fields == 1) last = first;
+            if (fields < 1) continue;
+            for (int c = first; c <= last; c++) cpus.push_back(c);
+        }
+        return cpus;
+    }
+
+    static NumaTopology detect() {
+        NumaTopology topo;
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+        auto usable = [&](int c) { return !have_mask || (c < CPU_SETSIZE && CPU_ISSET(c, &allowed)); };
+
+        for (int node = 0;; node++) {
+            ifstream in("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+            if (!in.is_open()) break;
+            string line;
+            getline(in, line);
+            vector<int> cpus;
+            for (int c : parse_cpu_list(line))
+                if (usable(c)) cpus.push_back(c);
+            topo.node_cpus.push_back(cpus);
+        }
+        bool any = false;
+        for (const auto& cpus : topo.node_cpus) any = any || !cpus.empty();
+        if (!any) {
+            topo.node_cpus.assign(1, vector<int>());
+            for (int c = 0; c < CPU_SETSIZE; c++)
+                if (have_mask ? CPU_ISSET(c, &allowed) : c < (int)thread::hardware_concurrency())
+                    topo.node_cpus[0].push_back(c);
+        }
+        return topo;
+    }
+
+    int num_nodes() const { return node_cpus.size(); }
+
+    int node_of_cpu(int cpu) const {
+        for (int node = 0; node < num_nodes(); node++)
+            if (find(node_cpus[node].begin(), node_cpus[node].end(), cpu) != node_cpus[node].end()) return node;
+        return -1;
+    }
+
+    // CPU of each of num_threads workers: "compact" fills a node's CPUs
+    // before moving to the next, "scatter" deals workers out to the nodes in
+    // turn. More workers than CPUs wrap around.
+    vector<int> assign_cpus(int num_threads, bool scatter) const {
+        vector<int> order;
+        if (scatter) {
+            size_t longest = 0;
+            for (const auto& cpus : node_cpus) longest = max(longest, cpus.size());
+            for (size_t i = 0; i < longest; i++)
+                for (const auto& cpus : node_cpus)
+                    if (i < cpus.size()) order.push_back(cpus[i]);
+        } else {
+            for (const auto& cpus : node_cpus) order.insert(order.end(), cpus.begin(), cpus.end());
+        }
+        vector<int> assigned;
+        for (int t = 0; t < num_threads && !order.empty(); t++) assigned.push_back(order[t % order.size()]);
+        return assigned;
+    }
+};
+
+inline bool pin_current_thread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+// Interleave this thread's new page allocations over the given number of
+// nodes (set_mempolicy(MPOL_INTERLEAVE)), or go back to the default local
+// policy with num_nodes = 0. Returns false where the kernel refuses, e.g.
+// without NUMA support.
+inline bool set_interleave_policy(int num_nodes) {
+#ifdef SYS_set_mempolicy
+    const int mpol_default = 0, mpol_interleave = 3;
+    if (num_nodes <= 0) return syscall(SYS_set_mempolicy, mpol_default, nullptr, 0) == 0;
+    vector<unsigned long> mask((num_nodes + 63) / 64, 0);
+    for (int node = 0; node < num_nodes; node++) mask[node / 64] |= 1UL << (node % 64);
+    return syscall(SYS_set_mempolicy, mpol_interleave, mask.data(), (unsigned long)num_nodes + 1) == 0;
+#else
+    (void)num_nodes;
+    return false;
+#endif
+}
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <bits/stdc++.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Hardware counters of one measured interval. A counter that could not be
+// opened (no PMU access in containers, perf_event_paranoid, non-Linux) stays
+// at -1, and the report prints it as n/a.
+struct PerfSample {
+    enum { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, DTLB_MISSES, NUM_COUNTERS };
+    long long value[NUM_COUNTERS] = {-1, -1, -1, -1, -1};
+
+    bool any() const {
+        for (long long v : value)
+            if (v >= 0) return true;
+        return false;
+    }
+
+    void merge(const PerfSample& other) {
+        for (int i = 0; i < NUM_COUNTERS; i++) {
+            if (other.value[i] < 0) continue;
+            value[i] = max(value[i], 0LL) + other.value[i];
+        }
+    }
+};
+
+// Counts the calling thread (user space only) between start() and stop()
+class PerfCounters {
+private:
+    int fds[PerfSample::NUM_COUNTERS] = {-1, -1, -1, -1, -1};
+    int open_errno = 0;
+
+public:
+    PerfCounters() {
+#ifdef __linux__
+        // dTLB load misses are a generic cache event: cache id, op, result
+        const unsigned long long configs[PerfSample::NUM_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+            PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+        for (int i = 0; i < PerfSample::NUM_COUNTERS; i++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = i == PerfSample::DTLB_MISSES ? PERF_TYPE_HW_CACHE : PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+            if (fds[i] < 0 && !open_errno) open_errno = errno;
+        }
+#else
+        open_errno = ENOSYS;
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds)
+            if (fd >= 0) close(fd);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        for (int fd : fds)
+            if (fd >= 0) return true;
+        return false;
+    }
+
+    // Reason the first unavailable counter could not be opened
+    string error() const { return open_errno ? strerror(open_errno) : ""; }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : fds) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // Values are scaled up when the kernel multiplexed the counters
+    PerfSample stop() {
+        PerfSample sample;
+#ifdef __linux__
+        for (int i = 0; i < PerfSample::NUM_COUNTERS; i++) {
+            if (fds[i] < 0) continue;
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            unsigned long long buf[3];
+            if (read(fds[i], buf, sizeof(buf)) != sizeof(buf)) continue;
+            double scale = (buf[2] > 0 && buf[2] < buf[1]) ? (double)buf[1] / buf[2] : 1.0;
+            sample.value[i] = buf[2] == 0 ? 0 : (long long)(buf[0] * scale);
+        }
+#endif
+        return sample;
+    }
+};
+
+// Per-phase hardware counter report printed with the run metrics
+class PerfReport {
+private:
+    vector<pair<string, PerfSample>> rows;
+
+public:
+    void add(const string& name, const PerfSample& sample) { rows.push_back(make_pair(name, sample)); }
+
+    static void print_value(ostream& out, long long v) {
+        out << setw(16);
+        if (v < 0)
+            out << "n/a";
+        else
+            out << v;
+    }
+
+    void print(ostream& out) const {
+        out << "Hardware counters:\n";
+        out << "  " << left << setw(22) << "phase" << right << setw(16) << "cycles" << setw(16) << "instructions"
+            << setw(8) << "IPC" << setw(16) << "cache-misses" << setw(16) << "branch-misses" << setw(16)
+            << "dTLB-misses" << "\n";
+        for (const auto& row : rows) {
+            const PerfSample& s = row.second;
+            out << "  " << left << setw(22) << row.first << right;
+            print_value(out, s.value[PerfSample::CYCLES]);
+            print_value(out, s.value[PerfSample::INSTRUCTIONS]);
+            out << setw(8);
+            if (s.value[PerfSample::CYCLES] > 0 && s.value[PerfSample::INSTRUCTIONS] >= 0)
+                out << fixed << setprecision(2) << (double)s.value[PerfSample::INSTRUCTIONS] / s.value[PerfSample::CYCLES]
+                    << defaultfloat;
+            else
+                out << "n/a";
+            print_value(out, s.value[PerfSample::CACHE_MISSES]);
+            print_value(out, s.value[PerfSample::BRANCH_MISSES]);
+            print_value(out, s.value[PerfSample::DTLB_MISSES]);
+            out << "\n";
+        }
+    }
+};
+
+// Measures the enclosing scope into a report row; does nothing without a report
+class PerfPhase {
+private:
+    PerfReport* report;
+    string name;
+    unique_ptr<PerfCounters> counters;
+
+public:
+    PerfPhase(PerfReport* report, const string& name) : report(report), name(name) {
+        if (!report) return;
+        counters.reset(new PerfCounters());
+        counters->start();
+    }
+    ~PerfPhase() {
+        if (report) report->add(name, counters->stop());
+    }
+};
+
+#endif
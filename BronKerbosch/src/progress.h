@@ -0,0 +1,101 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <bits/stdc++.h>
+
+#include "run_control.h"
+
+using namespace std;
+
+// Periodic progress line on stderr during the enumeration, read from the
+// run control's relaxed counters (updated once per completed root). The ETA
+// extrapolates the time per unit of estimated root cost seen so far in this
+// run to the cost of the remaining roots.
+class ProgressReporter {
+private:
+    RunControl& control;
+    double interval_s;
+    ostream& out;
+
+    thread reporter;
+    mutex m;
+    condition_variable cv;
+    bool finished = false;
+
+    chrono::steady_clock::time_point begin;
+    long long roots_at_start = 0, cliques_at_start = 0, nodes_at_start = 0, cost_at_start = 0;
+
+    static string format_rate(double per_s) {
+        ostringstream o;
+        o << fixed << setprecision(1);
+        if (per_s >= 1e6)
+            o << per_s / 1e6 << "M";
+        else if (per_s >= 1e3)
+            o << per_s / 1e3 << "k";
+        else
+            o << per_s;
+        return o.str();
+    }
+
+    static string format_eta(double s) {
+        ostringstream o;
+        long long t = (long long)(s + 0.5);
+        if (t >= 3600) o << t / 3600 << "h ";
+        if (t >= 60) o << (t / 60) % 60 << "m ";
+        o << t % 60 << "s";
+        return o.str();
+    }
+
+    void report() {
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        long long roots = control.completed_roots(), cliques = control.completed_cliques();
+        long long nodes = control.completed_nodes(), cost = control.completed_cost();
+        long long total = control.total_cost();
+
+        ostringstream line;
+        line << "[progress] " << fixed << setprecision(1) << elapsed << "s  roots " << roots << "/"
+             << control.num_roots() << " (" << (control.num_roots() ? roots * 100.0 / control.num_roots() : 100.0)
+             << "%)  cliques " << cliques << " (" << format_rate((cliques - cliques_at_start) / elapsed)
+             << "/s)  nodes " << format_rate((nodes - nodes_at_start) / elapsed) << "/s  ETA ";
+        if (cost > cost_at_start && total > 0)
+            line << format_eta(elapsed * (total - cost) / (cost - cost_at_start));
+        else
+            line << "?";
+        out << line.str() << endl;
+    }
+
+public:
+    ProgressReporter(RunControl& control, double interval_s, ostream& out = cerr)
+        : control(control), interval_s(interval_s), out(out) {}
+
+    ~ProgressReporter() { stop(); }
+
+    void start() {
+        begin = chrono::steady_clock::now();
+        roots_at_start = control.completed_roots();
+        cliques_at_start = control.completed_cliques();
+        nodes_at_start = control.completed_nodes();
+        cost_at_start = control.completed_cost();
+        reporter = thread([this]() {
+            unique_lock<mutex> lock(m);
+            auto next = begin;
+            while (true) {
+                next += chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(interval_s));
+                if (cv.wait_until(lock, next, [this]() { return finished; })) break;
+                report();
+            }
+        });
+    }
+
+    void stop() {
+        {
+            lock_guard<mutex> lock(m);
+            if (finished) return;
+            finished = true;
+        }
+        cv.notify_all();
+        if (reporter.joinable()) reporter.join();
+    }
+};
+
+#endif
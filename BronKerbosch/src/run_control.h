@@ -0,0 +1,267 @@
+#ifndef RUN_CONTROL_H
+#define RUN_CONTROL_H
+
+#include <bits/stdc++.h>
+
+using namespace std;
+
+// Time budget and resumable progress of one enumeration run. Progress is
+// kept per root (by position in the root order): a root's counts are added
+// only once its whole subtree has been searched, so a root that is cut off
+// by the time limit is simply searched again on resume.
+//
+// Checkpoint file (text, replaced atomically via rename):
+//   BKCHECKPOINT 1
+//   graph <n> <m> <edge-set hash>
+//   ordering <degeneracy|natural|peeled-degeneracy-<epsilon>>
+//   cliques <count>
+//   nodes <count>
+//   roots <completed> of <n>
+//   ranges <k>
+//   <first> <last>           k lines of completed rank ranges, inclusive
+class RunControl {
+private:
+    // Per-root done flags and relaxed counters: completing a root is a few
+    // atomic increments, read as they are by the progress reporter. Only a
+    // checkpoint needs the flags and counters to agree; it raises
+    // snapshot_pending and waits for the completions in flight, which
+    // announce themselves in completing (see enter_completion).
+    vector<atomic<char>> done;
+    mutex snapshot_mutex;  // one snapshot at a time
+    atomic<bool> snapshot_pending{false};
+    atomic<int> completing{0};
+    atomic<long long> cliques_done{0};
+    atomic<long long> nodes_done{0};
+    atomic<long long> roots_done{0};
+    vector<long long> root_cost;  // estimated cost per rank, for the ETA
+    atomic<long long> cost_done{0};
+    long long cost_total = 0;
+
+    string checkpoint_file;
+    string graph_id;
+    string ordering;
+    double interval_s = 60;
+    double time_limit_s = 0;  // 0 = unlimited
+
+    thread timer;
+    mutex timer_mutex;
+    condition_variable timer_cv;
+    bool finished = false;
+    bool time_limit_hit = false;
+
+public:
+    // Polled by the engine once per search tree node; raised by the timer
+    // thread or from a signal handler (a lock-free store is async-signal-safe)
+    atomic<bool> stop{false};
+
+    explicit RunControl(int num_roots) : done(num_roots) {
+        for (auto& flag : done) flag.store(0, memory_order_relaxed);
+    }
+
+    ~RunControl() { finish(); }
+
+    void set_time_limit(double seconds) { time_limit_s = seconds; }
+
+    // graph_id and ordering identify the run a checkpoint may be resumed by
+    void set_checkpoint(const string& filename, double every_s, const string& graph, const string& order_name) {
+        checkpoint_file = filename;
+        interval_s = max(1.0, every_s);
+        graph_id = graph;
+        ordering = order_name;
+    }
+
+    bool is_done(int rank) const { return done[rank].load(memory_order_relaxed); }
+    bool stopped() const { return stop.load(memory_order_relaxed); }
+    bool hit_time_limit() const { return time_limit_hit; }
+    long long completed_roots() const { return roots_done.load(memory_order_relaxed); }
+    long long completed_cliques() const { return cliques_done.load(memory_order_relaxed); }
+    long long completed_nodes() const { return nodes_done.load(memory_order_relaxed); }
+    long long completed_cost() const { return cost_done.load(memory_order_relaxed); }
+    long long total_cost() const { return cost_total; }
+    int num_roots() const { return done.size(); }
+
+    // Estimated cost of every root by rank, set before the search; roots
+    // already done count as done
+    void set_root_costs(const vector<long long>& costs) {
+        root_cost = costs;
+        cost_total = 0;
+        long long already = 0;
+        for (size_t i = 0; i < costs.size(); i++) {
+            cost_total += costs[i];
+            if (is_done(i)) already += costs[i];
+        }
+        cost_done.store(already, memory_order_relaxed);
+    }
+
+    void complete(int rank, long long cliques, long long nodes) {
+        bool gated = !checkpoint_file.empty();
+        if (gated) enter_completion();
+        if (!done[rank].exchange(1, memory_order_relaxed)) {
+            cliques_done.fetch_add(cliques, memory_order_relaxed);
+            nodes_done.fetch_add(nodes, memory_order_relaxed);
+            roots_done.fetch_add(1, memory_order_relaxed);
+            if (!root_cost.empty()) cost_done.fetch_add(root_cost[rank], memory_order_relaxed);
+        }
+        if (gated) completing.fetch_sub(1, memory_order_release);
+    }
+
+    // Announce a completion unless a snapshot is being taken, else wait for
+    // it. With sequentially consistent operations on both sides, either the
+    // snapshot sees this completion in completing and waits for it, or the
+    // completion sees snapshot_pending and backs off.
+    void enter_completion() {
+        for (;;) {
+            completing.fetch_add(1);
+            if (!snapshot_pending.load()) return;
+            completing.fetch_sub(1);
+            while (snapshot_pending.load()) this_thread::yield();
+        }
+    }
+
+    // Start the timer thread: raises stop at the time limit and writes the
+    // checkpoint every interval
+    void start() {
+        if (time_limit_s <= 0 && checkpoint_file.empty()) return;
+        timer = thread([this]() {
+            auto begin = chrono::steady_clock::now();
+            auto deadline = begin + chrono::duration_cast<chrono::steady_clock::duration>(
+                                        chrono::duration<double>(time_limit_s > 0 ? time_limit_s : 1e9));
+            auto next_checkpoint = begin + chrono::duration_cast<chrono::steady_clock::duration>(
+                                               chrono::duration<double>(interval_s));
+            unique_lock<mutex> lock(timer_mutex);
+            while (!finished) {
+                auto wake = checkpoint_file.empty() ? deadline : min(deadline, next_checkpoint);
+                timer_cv.wait_until(lock, wake, [this]() { return finished; });
+                if (finished) break;
+                auto now = chrono::steady_clock::now();
+                if (now >= deadline) {
+                    time_limit_hit = true;
+                    stop.store(true);
+                    break;
+                }
+                if (!checkpoint_file.empty() && now >= next_checkpoint) {
+                    lock.unlock();
+                    write_checkpoint();
+                    lock.lock();
+                    next_checkpoint = now + chrono::duration_cast<chrono::steady_clock::duration>(
+                                                chrono::duration<double>(interval_s));
+                }
+            }
+        });
+    }
+
+    // Stop the timer thread; the caller writes the final checkpoint
+    void finish() {
+        {
+            lock_guard<mutex> lock(timer_mutex);
+            finished = true;
+        }
+        timer_cv.notify_all();
+        if (timer.joinable()) timer.join();
+    }
+
+    bool write_checkpoint() {
+        if (checkpoint_file.empty()) return true;
+        string tmp = checkpoint_file + ".tmp";
+        ofstream out(tmp);
+        if (!out.is_open()) {
+            cerr << "Error: Could not open file " << tmp << " for writing." << endl;
+            return false;
+        }
+        vector<pair<int, int>> ranges;
+        long long cliques, nodes, roots;
+        {
+            lock_guard<mutex> lock(snapshot_mutex);
+            snapshot_pending.store(true);
+            while (completing.load() != 0) this_thread::yield();
+            for (int i = 0; i < (int)done.size(); i++) {
+                if (!is_done(i)) continue;
+                if (!ranges.empty() && ranges.back().second == i - 1)
+                    ranges.back().second = i;
+                else
+                    ranges.push_back(make_pair(i, i));
+            }
+            cliques = completed_cliques();
+            nodes = completed_nodes();
+            roots = completed_roots();
+            snapshot_pending.store(false);
+        }
+        out << "BKCHECKPOINT 1\n";
+        out << "graph " << graph_id << "\n";
+        out << "ordering " << ordering << "\n";
+        out << "cliques " << cliques << "\n";
+        out << "nodes " << nodes << "\n";
+        out << "roots " << roots << " of " << done.size() << "\n";
+        out << "ranges " << ranges.size() << "\n";
+        for (const auto& r : ranges) out << r.first << ' ' << r.second << "\n";
+        out.close();
+        if (!out || rename(tmp.c_str(), checkpoint_file.c_str()) != 0) {
+            cerr << "Error: Could not write checkpoint " << checkpoint_file << endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Restore progress from a checkpoint of the graph and ordering given to
+    // set_checkpoint
+    bool load_checkpoint(const string& filename) {
+        ifstream in(filename);
+        if (!in.is_open()) {
+            cerr << "Error: Could not open checkpoint " << filename << endl;
+            return false;
+        }
+        string magic, key, saved_ordering, of;
+        int version;
+        string n, m, fingerprint;
+        long long cliques, nodes, roots, total;
+        size_t num_ranges;
+        if (!(in >> magic >> version) || magic != "BKCHECKPOINT" || version != 1) {
+            cerr << "Error: " << filename << " is not a checkpoint file" << endl;
+            return false;
+        }
+        if (!(in >> key >> n >> m >> fingerprint) || key != "graph" || n + " " + m + " " + fingerprint != graph_id) {
+            cerr << "Error: checkpoint " << filename << " was written for a different graph" << endl;
+            return false;
+        }
+        if (!(in >> key >> saved_ordering) || saved_ordering != ordering) {
+            cerr << "Error: checkpoint " << filename << " uses " << saved_ordering << " ordering, this run uses "
+                 << ordering << endl;
+            return false;
+        }
+        if (!(in >> key >> cliques >> key >> nodes >> key >> roots >> of >> total >> key >> num_ranges)) {
+            cerr << "Error: checkpoint " << filename << " is truncated" << endl;
+            return false;
+        }
+        if (total != (long long)done.size()) {
+            cerr << "Error: checkpoint " << filename << " has " << total << " roots, this run has " << done.size()
+                 << endl;
+            return false;
+        }
+        cliques_done = cliques;
+        nodes_done = nodes;
+        roots_done = 0;
+        for (size_t r = 0; r < num_ranges; r++) {
+            int first, last;
+            if (!(in >> first >> last) || first < 0 || last >= (int)done.size() || first > last) {
+                cerr << "Error: checkpoint " << filename << " has an invalid range" << endl;
+                return false;
+            }
+            // Overlapping ranges would count their roots twice
+            for (int i = first; i <= last; i++) {
+                if (done[i].exchange(1, memory_order_relaxed)) {
+                    cerr << "Error: checkpoint " << filename << " has overlapping ranges" << endl;
+                    return false;
+                }
+            }
+            roots_done += last - first + 1;
+        }
+        if (roots_done != roots) {
+            cerr << "Error: checkpoint " << filename << " lists " << roots_done << " done roots, expected " << roots
+                 << endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif
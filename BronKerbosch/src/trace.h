@@ -0,0 +1,169 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <bits/stdc++.h>
+
+#include "async_output.h"
+
+using namespace std;
+
+// Timeline of the run in Chrome trace format (chrome://tracing, Perfetto).
+// Every thread records into its own ring buffer, so recording takes no
+// locks. A ring grows as events arrive, up to a fixed number of events;
+// once it is full the oldest events are overwritten.
+struct TraceEvent {
+    const char* name;  // must point to a string literal
+    long long begin_ns;
+    long long end_ns;
+    long long arg0;
+    long long arg1;
+};
+
+class TraceBuffer {
+private:
+    vector<TraceEvent> ring;
+    size_t capacity;
+    size_t next = 0;
+    size_t recorded = 0;
+
+public:
+    explicit TraceBuffer(size_t capacity) : capacity(max<size_t>(1, capacity)) {}
+
+    void record(const TraceEvent& ev) {
+        if (ring.size() < capacity) {
+            if (ring.size() == ring.capacity()) ring.reserve(min(capacity, max<size_t>(256, 2 * ring.size())));
+            ring.push_back(ev);
+        } else {
+            ring[next] = ev;
+        }
+        next = (next + 1) % capacity;
+        recorded++;
+    }
+
+    long long bytes() const { return (long long)ring.capacity() * sizeof(TraceEvent); }
+
+    size_t dropped() const { return recorded > ring.size() ? recorded - ring.size() : 0; }
+
+    // Events in recording order, oldest surviving first
+    vector<TraceEvent> events() const {
+        vector<TraceEvent> out;
+        size_t count = min(recorded, ring.size());
+        size_t first = recorded > ring.size() ? next : 0;
+        for (size_t i = 0; i < count; i++) out.push_back(ring[(first + i) % ring.size()]);
+        return out;
+    }
+};
+
+class TraceWriter {
+private:
+    chrono::steady_clock::time_point epoch;
+    size_t capacity;
+    vector<unique_ptr<TraceBuffer>> buffers;  // indexed by trace thread id
+    vector<string> thread_names;
+
+public:
+    static const size_t kDefaultEvents = 1 << 20;
+
+    explicit TraceWriter(size_t events_per_thread = kDefaultEvents)
+        : epoch(chrono::steady_clock::now()), capacity(events_per_thread) {}
+
+    // Must be called before the threads using ids [0, count) start recording
+    void ensure_threads(int count) {
+        while ((int)buffers.size() < count) {
+            buffers.emplace_back(new TraceBuffer(capacity));
+            thread_names.push_back(buffers.size() == 1 ? "main" : "worker " + to_string(buffers.size() - 1));
+        }
+    }
+
+    // Bytes held by the ring buffers so far
+    long long bytes() const {
+        long long total = 0;
+        for (const auto& buffer : buffers) total += buffer->bytes();
+        return total;
+    }
+
+    // Bytes one thread's ring holds once it is full
+    long long max_bytes_per_thread() const { return (long long)capacity * sizeof(TraceEvent); }
+
+    long long now() const {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+    }
+
+    void record(int tid, const char* name, long long begin_ns, long long end_ns, long long arg0 = -1, long long arg1 = -1) {
+        TraceEvent ev = {name, begin_ns, end_ns, arg0, arg1};
+        buffers[tid]->record(ev);
+    }
+
+    // Argument names for each event name; events without an entry get none
+    static void write_args(ostream& out, const TraceEvent& ev) {
+        const char* a0 = nullptr;
+        const char* a1 = nullptr;
+        if (!strcmp(ev.name, "root")) {
+            a0 = "vertex";
+            a1 = "rank";
+        } else if (!strcmp(ev.name, "claim")) {
+            a0 = "first_rank";
+            a1 = "last_rank";
+        }
+        if (!a0) return;
+        out << ",\"args\":{\"" << a0 << "\":" << ev.arg0;
+        if (a1) out << ",\"" << a1 << "\":" << ev.arg1;
+        out << "}";
+    }
+
+    bool write_json(const string& filename) const {
+        AsyncOutput out(filename);
+        if (!out.is_open()) {
+            cerr << "Error: Could not open file " << filename << " for writing." << endl;
+            return false;
+        }
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        size_t total = 0, dropped = 0;
+        out << fixed << setprecision(3);
+        for (size_t tid = 0; tid < buffers.size(); tid++) {
+            if (!first) out << ",\n";
+            first = false;
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                << ",\"args\":{\"name\":\"" << thread_names[tid] << "\"}}";
+            for (const TraceEvent& ev : buffers[tid]->events()) {
+                out << ",\n{\"name\":\"" << ev.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << ev.begin_ns / 1000.0 << ",\"dur\":" << (ev.end_ns - ev.begin_ns) / 1000.0;
+                write_args(out, ev);
+                out << "}";
+                total++;
+            }
+            dropped += buffers[tid]->dropped();
+        }
+        out << "\n]}\n";
+        if (!out.close()) {
+            cerr << "Error: Could not write " << filename << endl;
+            return false;
+        }
+
+        cout << "Trace exported to " << filename << " (" << total << " events";
+        if (dropped > 0) cout << ", " << dropped << " oldest events overwritten";
+        cout << ")" << endl;
+        cout << "  Output: " << out.stats().summary() << endl;
+        return true;
+    }
+};
+
+// Records one complete event covering the lifetime of the scope
+class TraceScope {
+private:
+    TraceWriter* trace;
+    int tid;
+    const char* name;
+    long long begin_ns;
+
+public:
+    TraceScope(TraceWriter* trace, int tid, const char* name)
+        : trace(trace), tid(tid), name(name), begin_ns(trace ? trace->now() : 0) {}
+    ~TraceScope() {
+        if (trace) trace->record(tid, name, begin_ns, trace->now());
+    }
+};
+
+#endif
@@ -128,6 +128,13 @@ export function NodeInfoPanel({ node, solutions }: NodeInfoPanelProps) {
             }}>
               {node.pruned_by_pivot ? 'Yes' : 'No'}
             </span>
+
+            {node.partial && (
+              <>
+                <strong>Partial:</strong>
+                <span style={{ color: '#e67e22', fontWeight: 'bold' }}>Yes (run interrupted)</span>
+              </>
+            )}
           </div>
         ) : (
           <div style={{
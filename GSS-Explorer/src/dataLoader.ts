@@ -20,7 +20,8 @@ export function parseCSV(csvText: string): TreeNode[] {
       current_clique: values[7].replace(/"/g, ''),
       x_set: values[8].replace(/"/g, ''),
       p_set: values[9].replace(/"/g, ''),
-      pruned_by_pivot: values[10] === 'true'
+      pruned_by_pivot: values[10] === 'true',
+      partial: values[11] === 'true'
     };
 
     nodes.push(node);
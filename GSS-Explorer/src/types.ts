@@ -10,5 +10,6 @@ export type TreeNode = {
   x_set: string;
   p_set: string;
   pruned_by_pivot: boolean;
+  partial?: boolean;  // only in exports of interrupted runs: subtree not finished
   children?: TreeNode[];
 }